@@ -0,0 +1,559 @@
+// Microbenchmark of the ECS component containers
+// Compares the sparse set index of ComponentContainer against the std::unordered_map
+// index it replaced, at the entity counts we expect from small levels up to stress tests.
+// "sparse" is the default paged storage, "sparse vec" the same container over a std::vector.
+// With WORLD_ODYSSEY_ARCHETYPE_STORAGE the level scenarios also run on ArchetypeStorage.
+// The snapshot table is the time to snapshot a whole level and to restore it into an empty registry.
+// The parallel table steps the motions of a container on the calling thread and with parallel_for_each on a ThreadPool.
+// The last table finds the overlapping boxes of a wave of enemies by testing all pairs and with the SpatialHashGrid broadphase.
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+#include <vector>
+
+// internal
+#include "spatial_hash.hpp"
+#include "tiny_ecs.hpp"
+#ifdef WORLD_ODYSSEY_ARCHETYPE_STORAGE
+#include "archetype_storage.hpp"
+#endif
+
+// Same layout as the Motion component (position, angle, velocity, scale) without pulling in glm
+struct BenchMotion
+{
+	float position[2] = { 0, 0 };
+	float angle = 0;
+	float velocity[2] = { 0, 0 };
+	float scale[2] = { 10, 10 };
+};
+
+// An empty tag component like Player or Obstacle
+struct BenchTag
+{
+};
+
+// The other components of a scorpion (createScorpion) and a rock (createRock)
+struct BenchRenderRequest
+{
+	int texture = 0;
+	int effect = 0;
+	int geometry = 0;
+};
+struct BenchHealth
+{
+	int health = 3;
+};
+struct BenchMeshPtr
+{
+	void* mesh = nullptr;
+};
+struct BenchDeadly {};
+struct BenchEnemy {};
+struct BenchScorpion {};
+struct BenchObstacle {};
+
+#define BENCH_LEVEL_COMPONENTS BenchMotion, BenchRenderRequest, BenchHealth, BenchMeshPtr, BenchDeadly, BenchEnemy, BenchScorpion, BenchObstacle
+typedef BasicRegistry<BENCH_LEVEL_COMPONENTS> BenchRegistry;
+
+// The previous hash map based container, kept here as the baseline
+template <typename Component>
+class HashMapContainer
+{
+	std::unordered_map<unsigned int, unsigned int> map_entity_componentID;
+public:
+	std::vector<Component> components;
+	std::vector<Entity> entities;
+
+	Component& insert(Entity e, Component c)
+	{
+		map_entity_componentID[e] = (unsigned int)components.size();
+		components.push_back(std::move(c));
+		entities.push_back(e);
+		return components.back();
+	}
+
+	Component& get(Entity e) {
+		return components[map_entity_componentID[e]];
+	}
+
+	bool has(Entity entity) {
+		return map_entity_componentID.count(entity) > 0;
+	}
+
+	void remove(Entity e)
+	{
+		if (has(e))
+		{
+			int cID = map_entity_componentID[e];
+			components[cID] = std::move(components.back());
+			entities[cID] = entities.back();
+			map_entity_componentID[entities.back()] = cID;
+			map_entity_componentID.erase(e);
+			components.pop_back();
+			entities.pop_back();
+		}
+	}
+};
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Timings
+{
+	double insert_ns;
+	double has_ns;
+	double get_ns;
+	double remove_ns;
+};
+
+static double ns_per_op(Clock::time_point start, Clock::time_point end, size_t ops)
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (double)ops;
+}
+
+// Keeps the optimizer from discarding the lookups
+static volatile float sink;
+
+template <class Container>
+Timings run(const std::vector<Entity>& owners, const std::vector<Entity>& queries, int rounds)
+{
+	Timings t = {};
+	for (int round = 0; round < rounds; round++)
+	{
+		Container container;
+
+		auto start = Clock::now();
+		for (Entity e : owners)
+			container.insert(e, BenchMotion());
+		auto end = Clock::now();
+		t.insert_ns += ns_per_op(start, end, owners.size());
+
+		// Half of the queries hit, as in the registry.X.has(...) chains of the collision handling
+		size_t hits = 0;
+		start = Clock::now();
+		for (Entity e : queries)
+			hits += container.has(e);
+		end = Clock::now();
+		t.has_ns += ns_per_op(start, end, queries.size());
+		sink = (float)hits;
+
+		// Random access by entity, as in the loops that walk one container and get() from another
+		float sum = 0;
+		start = Clock::now();
+		for (Entity e : owners)
+		{
+			BenchMotion& motion = container.get(e);
+			motion.position[0] += motion.velocity[0] + 1.f;
+			sum += motion.position[0];
+		}
+		end = Clock::now();
+		t.get_ns += ns_per_op(start, end, owners.size());
+		sink = sum;
+
+		start = Clock::now();
+		for (Entity e : queries)
+			container.remove(e);
+		end = Clock::now();
+		t.remove_ns += ns_per_op(start, end, queries.size());
+	}
+	t.insert_ns /= rounds;
+	t.has_ns /= rounds;
+	t.get_ns /= rounds;
+	t.remove_ns /= rounds;
+	return t;
+}
+
+// has() on a tag component, the default container of an empty type uses TagStorage
+template <class Container>
+double run_tag_has(const std::vector<Entity>& owners, const std::vector<Entity>& queries, int rounds)
+{
+	double has_ns = 0;
+	for (int round = 0; round < rounds; round++)
+	{
+		Container container;
+		for (Entity e : owners)
+			container.insert(e, BenchTag());
+
+		size_t hits = 0;
+		auto start = Clock::now();
+		for (Entity e : queries)
+			hits += container.has(e);
+		auto end = Clock::now();
+		has_ns += ns_per_op(start, end, queries.size());
+		sink = (float)hits;
+	}
+	return has_ns / rounds;
+}
+
+struct LevelTimings
+{
+	double spawn_ns;
+	double follow_ns;
+	double render_ns;
+	double destroy_ns;
+};
+
+// A level of scorpions and rocks: spawn them component by component as world_init does, run the Deadly follow loop
+// and the render loop over Motion, then destroy everything. 'Level' adapts the storage to the same calls.
+template <class Level>
+LevelTimings run_level(size_t count, int rounds)
+{
+	LevelTimings t = {};
+	std::vector<Entity> entities;
+	entities.reserve(count);
+	for (int round = 0; round < rounds; round++)
+	{
+		Level level;
+		entities.clear();
+
+		auto start = Clock::now();
+		for (size_t i = 0; i < count; i++)
+		{
+			Entity e = level.create();
+			entities.push_back(e);
+			level.spawn(e, i % 4 != 0);
+		}
+		auto end = Clock::now();
+		t.spawn_ns += ns_per_op(start, end, count);
+
+		start = Clock::now();
+		level.follow(100.f);
+		end = Clock::now();
+		t.follow_ns += ns_per_op(start, end, count);
+
+		start = Clock::now();
+		sink = level.render();
+		end = Clock::now();
+		t.render_ns += ns_per_op(start, end, count);
+
+		start = Clock::now();
+		for (Entity e : entities)
+			level.destroy(e);
+		end = Clock::now();
+		t.destroy_ns += ns_per_op(start, end, count);
+	}
+	t.spawn_ns /= rounds;
+	t.follow_ns /= rounds;
+	t.render_ns /= rounds;
+	t.destroy_ns /= rounds;
+	return t;
+}
+
+// The level on the per-type ComponentContainers
+struct ContainerLevel
+{
+	BenchRegistry registry;
+
+	Entity create() { return registry.create(); }
+
+	template <typename Component>
+	void add(Entity e, Component c = Component()) { registry.get<Component>().insert(e, c); }
+
+	void spawn(Entity e, bool scorpion)
+	{
+		add<BenchMotion>(e);
+		add<BenchMeshPtr>(e);
+		add<BenchRenderRequest>(e);
+		if (scorpion)
+		{
+			add<BenchDeadly>(e);
+			add<BenchEnemy>(e);
+			add<BenchHealth>(e);
+			add<BenchScorpion>(e);
+		}
+		else
+			add<BenchObstacle>(e);
+	}
+
+	void follow(float target)
+	{
+		registry.view<BenchDeadly, BenchMotion>().each([&](Entity, auto&&, auto&& motion) {
+			motion.velocity[0] = (target - motion.position[0]) * 0.5f;
+		});
+	}
+
+	float render()
+	{
+		float sum = 0;
+		registry.view<BenchRenderRequest, BenchMotion>().each([&](Entity, auto&& request, auto&& motion) {
+			sum += motion.position[0] * motion.scale[0] + (float)request.texture;
+		});
+		return sum;
+	}
+
+	void destroy(Entity e) { registry.remove_all_components_of(e); }
+};
+
+#ifdef WORLD_ODYSSEY_ARCHETYPE_STORAGE
+// The same level on ArchetypeStorage
+struct ArchetypeLevel
+{
+	ArchetypeStorage<BENCH_LEVEL_COMPONENTS> storage;
+
+	Entity create() { return storage.create(); }
+
+	template <typename Component>
+	void add(Entity e, Component c = Component()) { storage.emplace<Component>(e, c); }
+
+	void spawn(Entity e, bool scorpion)
+	{
+		add<BenchMotion>(e);
+		add<BenchMeshPtr>(e);
+		add<BenchRenderRequest>(e);
+		if (scorpion)
+		{
+			add<BenchDeadly>(e);
+			add<BenchEnemy>(e);
+			add<BenchHealth>(e);
+			add<BenchScorpion>(e);
+		}
+		else
+			add<BenchObstacle>(e);
+	}
+
+	void follow(float target)
+	{
+		storage.each<BenchDeadly, BenchMotion>([&](Entity, BenchDeadly&, BenchMotion& motion) {
+			motion.velocity[0] = (target - motion.position[0]) * 0.5f;
+		});
+	}
+
+	float render()
+	{
+		float sum = 0;
+		storage.each<BenchRenderRequest, BenchMotion>([&](Entity, BenchRenderRequest& request, BenchMotion& motion) {
+			sum += motion.position[0] * motion.scale[0] + (float)request.texture;
+		});
+		return sum;
+	}
+
+	void destroy(Entity e) { storage.remove_all_components_of(e); }
+};
+#endif
+
+struct SnapshotTimings
+{
+	double snapshot_us;
+	double restore_us;
+	size_t bytes;
+};
+
+// Snapshots a level of scorpions and rocks and restores it into a new registry, the times are for the whole level
+static SnapshotTimings run_snapshot(size_t count, int rounds)
+{
+	SnapshotTimings t = {};
+	ContainerLevel level;
+	for (size_t i = 0; i < count; i++)
+		level.spawn(level.create(), i % 4 != 0);
+
+	Snapshot snapshot;
+	for (int round = 0; round < rounds; round++)
+	{
+		auto start = Clock::now();
+		level.registry.snapshot(snapshot);
+		auto end = Clock::now();
+		t.snapshot_us += ns_per_op(start, end, 1000);
+
+		BenchRegistry restored;
+		start = Clock::now();
+		restored.restore(snapshot);
+		end = Clock::now();
+		t.restore_us += ns_per_op(start, end, 1000);
+	}
+	t.snapshot_us /= rounds;
+	t.restore_us /= rounds;
+	t.bytes = snapshot.size();
+	return t;
+}
+
+struct ParallelTimings
+{
+	double serial_ns;
+	double parallel_ns;
+};
+
+// Steps every motion of a container in one loop and in chunks on the pool, per motion
+static ParallelTimings run_parallel(size_t count, int rounds, ThreadPool& pool)
+{
+	ParallelTimings t = {};
+	EntityManager ids;
+	ComponentContainer<BenchMotion> motions;
+	for (size_t i = 0; i < count; i++)
+	{
+		BenchMotion& motion = motions.emplace(Entity(ids.create()));
+		motion.velocity[0] = (float)(i % 7);
+		motion.velocity[1] = 1;
+	}
+	auto step = [](Entity, BenchMotion& motion) {
+		motion.position[0] += motion.velocity[0] * 0.016f;
+		motion.position[1] += motion.velocity[1] * 0.016f;
+		motion.velocity[1] -= 9.8f * 0.016f;
+		motion.angle = motion.angle * 0.99f + 0.01f;
+	};
+
+	auto start = Clock::now();
+	for (int round = 0; round < rounds; round++)
+		for (size_t i = 0; i < motions.size(); i++)
+			step(motions.entities[i], motions.components[i]);
+	auto end = Clock::now();
+	t.serial_ns = ns_per_op(start, end, count * rounds);
+
+	start = Clock::now();
+	for (int round = 0; round < rounds; round++)
+		motions.parallel_for_each(pool, step);
+	end = Clock::now();
+	t.parallel_ns = ns_per_op(start, end, count * rounds);
+
+	sink = motions.components[count / 2].position[1];
+	return t;
+}
+
+struct BroadphaseTimings
+{
+	double all_pairs_us;
+	double grid_us;
+	size_t overlaps;
+};
+
+// Enemy sized boxes (SCORPION_BB_WIDTH/HEIGHT) spread so that each overlaps a few others, per step.
+// The all pairs loop is skipped above 'all_pairs_limit' boxes.
+static BroadphaseTimings run_broadphase(size_t count, int rounds, size_t all_pairs_limit, std::default_random_engine& rng)
+{
+	BroadphaseTimings t = {};
+	struct Box { float min_x, min_y, max_x, max_y; };
+	float side = 100.f * sqrtf((float)count);
+	std::uniform_real_distribution<float> position(0.f, side);
+	std::vector<Box> boxes(count);
+	for (Box& box : boxes)
+	{
+		box.min_x = position(rng);
+		box.min_y = position(rng);
+		box.max_x = box.min_x + 180.f;
+		box.max_y = box.min_y + 121.f;
+	}
+	auto overlap = [&](size_t i, size_t j) {
+		return boxes[i].min_x < boxes[j].max_x && boxes[j].min_x < boxes[i].max_x && boxes[i].min_y < boxes[j].max_y && boxes[j].min_y < boxes[i].max_y;
+	};
+
+	if (count <= all_pairs_limit)
+	{
+		size_t overlaps = 0;
+		auto start = Clock::now();
+		for (int round = 0; round < rounds; round++)
+			for (size_t i = 0; i < count; i++)
+				for (size_t j = i + 1; j < count; j++)
+					overlaps += overlap(i, j);
+		auto end = Clock::now();
+		t.all_pairs_us = ns_per_op(start, end, 1000 * rounds);
+		sink = (float)overlaps;
+	}
+
+	SpatialHashGrid grid(128.f);
+	size_t overlaps = 0;
+	auto start = Clock::now();
+	for (int round = 0; round < rounds; round++)
+	{
+		grid.clear();
+		for (size_t i = 0; i < count; i++)
+			grid.insert((uint32_t)i, boxes[i].min_x, boxes[i].min_y, boxes[i].max_x, boxes[i].max_y);
+		for (const std::pair<uint32_t, uint32_t>& pair : grid.candidate_pairs())
+			overlaps += overlap(pair.first, pair.second);
+	}
+	auto end = Clock::now();
+	t.grid_us = ns_per_op(start, end, 1000 * rounds);
+	t.overlaps = overlaps / rounds;
+	return t;
+}
+
+static void print_level(size_t count, const char* name, const LevelTimings& t)
+{
+	printf("%-8zu %-10s %12.2f %12.2f %12.2f %12.2f\n", count, name, t.spawn_ns, t.follow_ns, t.render_ns, t.destroy_ns);
+}
+
+int main()
+{
+	std::default_random_engine rng(13);
+	// The containers don't create entities, the ids come from here
+	EntityManager ids;
+	const size_t entity_counts[] = { 1000, 10000, 100000 };
+
+	printf("%-8s %-10s %12s %12s %12s %12s\n", "entities", "container", "insert ns", "has ns", "get ns", "remove ns");
+	for (size_t count : entity_counts)
+	{
+		// Every other entity owns the component so that the lookups see both hits and misses
+		std::vector<Entity> all;
+		all.reserve(count * 2);
+		for (size_t i = 0; i < count * 2; i++)
+			all.push_back(Entity(ids.create()));
+		std::vector<Entity> owners;
+		owners.reserve(count);
+		for (size_t i = 0; i < all.size(); i += 2)
+			owners.push_back(all[i]);
+		std::shuffle(owners.begin(), owners.end(), rng);
+		std::vector<Entity> queries = all;
+		std::shuffle(queries.begin(), queries.end(), rng);
+
+		int rounds = (int)(1000000 / count);
+		Timings map = run<HashMapContainer<BenchMotion>>(owners, queries, rounds);
+		Timings sparse = run<ComponentContainer<BenchMotion>>(owners, queries, rounds);
+		Timings sparse_vector = run<ComponentContainer<BenchMotion, std::vector<BenchMotion>>>(owners, queries, rounds);
+
+		printf("%-8zu %-10s %12.2f %12.2f %12.2f %12.2f\n", count, "hash map", map.insert_ns, map.has_ns, map.get_ns, map.remove_ns);
+		printf("%-8zu %-10s %12.2f %12.2f %12.2f %12.2f\n", count, "sparse", sparse.insert_ns, sparse.has_ns, sparse.get_ns, sparse.remove_ns);
+		printf("%-8zu %-10s %12.2f %12.2f %12.2f %12.2f\n", count, "sparse vec", sparse_vector.insert_ns, sparse_vector.has_ns, sparse_vector.get_ns, sparse_vector.remove_ns);
+
+		double tag_vector = run_tag_has<ComponentContainer<BenchTag, std::vector<BenchTag>>>(owners, queries, rounds);
+		double tag_bits = run_tag_has<ComponentContainer<BenchTag>>(owners, queries, rounds);
+		printf("%-8zu %-10s %12s %12.2f\n", count, "tag vector", "", tag_vector);
+		printf("%-8zu %-10s %12s %12.2f\n", count, "tag bits", "", tag_bits);
+	}
+
+	// Per entity of the level
+	printf("\n%-8s %-10s %12s %12s %12s %12s\n", "entities", "storage", "spawn ns", "follow ns", "render ns", "destroy ns");
+	for (size_t count : entity_counts)
+	{
+		int rounds = (int)(1000000 / count);
+		print_level(count, "containers", run_level<ContainerLevel>(count, rounds));
+#ifdef WORLD_ODYSSEY_ARCHETYPE_STORAGE
+		print_level(count, "archetypes", run_level<ArchetypeLevel>(count, rounds));
+#endif
+	}
+
+	// Per level
+	printf("\n%-8s %-10s %12s %12s %12s\n", "entities", "storage", "snapshot us", "restore us", "bytes");
+	for (size_t count : entity_counts)
+	{
+		int rounds = (int)(100000 / count);
+		SnapshotTimings t = run_snapshot(count, rounds);
+		printf("%-8zu %-10s %12.2f %12.2f %12zu\n", count, "containers", t.snapshot_us, t.restore_us, t.bytes);
+	}
+
+	// Per motion
+	ThreadPool pool;
+	printf("\n%-8s %-10s %12s %12s\n", "entities", "threads", "serial ns", "parallel ns");
+	for (size_t count : entity_counts)
+	{
+		int rounds = (int)(10000000 / count);
+		ParallelTimings t = run_parallel(count, rounds, pool);
+		printf("%-8zu %-10zu %12.2f %12.2f\n", count, pool.threads(), t.serial_ns, t.parallel_ns);
+	}
+
+	// Per step, the all pairs loop takes minutes at the largest count
+	printf("\n%-8s %-10s %12s %12s\n", "entities", "overlaps", "all pairs us", "grid us");
+	for (size_t count : entity_counts)
+	{
+		int rounds = std::max(1, (int)(100000 / count));
+		BroadphaseTimings t = run_broadphase(count, rounds, 10000, rng);
+		if (t.all_pairs_us > 0)
+			printf("%-8zu %-10zu %12.2f %12.2f\n", count, t.overlaps, t.all_pairs_us, t.grid_us);
+		else
+			printf("%-8zu %-10zu %12s %12.2f\n", count, t.overlaps, "-", t.grid_us);
+	}
+
+	return EXIT_SUCCESS;
+}
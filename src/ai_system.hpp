@@ -9,4 +9,9 @@ class AISystem
 {
 public:
 	void step(float elapsed_ms);
+
+	AISystem(ECSRegistry& registry) : registry(registry) {}
+
+private:
+	ECSRegistry& registry;
 };
\ No newline at end of file
@@ -0,0 +1,296 @@
+#pragma once
+
+// stlib
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// internal
+#include "tiny_ecs.hpp"
+
+// Archetype based storage, the alternative to the per-type ComponentContainers of BasicRegistry.
+// Entities with the same set of components (e.g. every scorpion from createScorpion) share an archetype. Its rows live in
+// fixed-size chunks with one column per component, so a loop over several components walks each chunk linearly without lookups.
+// Adding or removing a component moves the entity's row to another archetype, which makes structural changes more expensive.
+// Built and benchmarked against the containers when WORLD_ODYSSEY_ARCHETYPE_STORAGE is on, see CMakeLists.txt.
+template <typename... Components>
+class ArchetypeStorage
+{
+public:
+	static constexpr size_t chunk_bytes = 16 * 1024;
+	static constexpr size_t chunk_alignment = 64;
+	static constexpr size_t type_count = sizeof...(Components);
+
+	static_assert(type_count <= sizeof(ComponentMask) * 8, "More component types than signature bits");
+
+	// The bits of the component types, e.g. mask<Motion, Deadly>()
+	template <typename... Cs>
+	static constexpr ComponentMask mask() {
+		return ((ComponentMask(1) << index_of_type<Cs, Components...>::value) | ... | ComponentMask(0));
+	}
+
+private:
+	// How to move and destroy a component of a type known only by its index
+	struct TypeInfo
+	{
+		size_t size;
+		size_t alignment;
+		void (*move_construct)(void* destination, void* source);
+		void (*destroy)(void* component);
+	};
+
+	template <typename T>
+	static TypeInfo type_info_of()
+	{
+		return {
+			sizeof(T), alignof(T),
+			[](void* destination, void* source) { new (destination) T(std::move(*(T*)source)); },
+			[](void* component) { ((T*)component)->~T(); }
+		};
+	}
+
+	static const TypeInfo& type_info(size_t type)
+	{
+		static const TypeInfo table[] = { type_info_of<Components>()... };
+		return table[type];
+	}
+
+	struct ChunkDeleter
+	{
+		void operator()(char* p) const { ::operator delete(p, std::align_val_t(chunk_alignment)); }
+	};
+	typedef std::unique_ptr<char[], ChunkDeleter> Chunk;
+
+	// A chunk starts with the entity column followed by one column per component type in the mask.
+	// Row r lives in chunk r / capacity at slot r % capacity, only the last used chunk is partly filled.
+	// Emptied chunks are kept for reuse like the capacity of a std::vector, entities passing through an
+	// archetype while their components are added one by one would otherwise allocate a chunk each.
+	struct Archetype
+	{
+		ComponentMask mask = 0;
+		size_t capacity = 0;
+		size_t offsets[type_count] = {};
+		std::vector<Chunk> chunks;
+		size_t size = 0;
+
+		Entity* entities(size_t chunk) { return (Entity*)chunks[chunk].get(); }
+		char* column(size_t chunk, size_t type) { return chunks[chunk].get() + offsets[type]; }
+		Entity& entity_at(size_t row) { return entities(row / capacity)[row % capacity]; }
+		void* at(size_t row, size_t type) { return column(row / capacity, type) + type_info(type).size * (row % capacity); }
+		size_t rows_in(size_t chunk) const { return std::min(capacity, size - chunk * capacity); }
+	};
+
+	// Where the components of an entity are, indexed by Entity::index()
+	struct Location
+	{
+		Archetype* archetype = nullptr;
+		size_t row = 0;
+	};
+
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::vector<Location> locations;
+	EntityManager entity_manager;
+
+	Location* find(Entity e)
+	{
+		if (e.index() >= locations.size())
+			return nullptr;
+		Location& location = locations[e.index()];
+		if (!location.archetype || location.archetype->entity_at(location.row) != e)
+			return nullptr;
+		return &location;
+	}
+
+	// There are few archetypes per level, a linear search is cheaper than hashing
+	Archetype* archetype_for(ComponentMask mask)
+	{
+		for (auto& archetype : archetypes)
+			if (archetype->mask == mask)
+				return archetype.get();
+
+		std::unique_ptr<Archetype> archetype(new Archetype());
+		archetype->mask = mask;
+		// Size the columns for the worst case padding between them
+		size_t row_bytes = sizeof(Entity);
+		size_t padding = 0;
+		for (size_t type = 0; type < type_count; type++)
+			if (mask & (ComponentMask(1) << type))
+			{
+				row_bytes += type_info(type).size;
+				padding += type_info(type).alignment;
+			}
+		archetype->capacity = (chunk_bytes - padding) / row_bytes;
+		assert(archetype->capacity > 0 && "Archetype row doesn't fit in a chunk");
+		size_t offset = sizeof(Entity) * archetype->capacity;
+		for (size_t type = 0; type < type_count; type++)
+			if (mask & (ComponentMask(1) << type))
+			{
+				size_t alignment = type_info(type).alignment;
+				offset = (offset + alignment - 1) / alignment * alignment;
+				archetype->offsets[type] = offset;
+				offset += type_info(type).size * archetype->capacity;
+			}
+		archetypes.push_back(std::move(archetype));
+		return archetypes.back().get();
+	}
+
+	size_t push_row(Archetype& archetype, Entity e)
+	{
+		if (archetype.size == archetype.chunks.size() * archetype.capacity)
+			archetype.chunks.emplace_back((char*)::operator new(chunk_bytes, std::align_val_t(chunk_alignment)));
+		size_t row = archetype.size++;
+		archetype.entity_at(row) = e;
+		return row;
+	}
+
+	// Destroys the components at 'row' and fills the hole with the last row
+	void erase_row(Archetype& archetype, size_t row)
+	{
+		size_t last = archetype.size - 1;
+		for (size_t type = 0; type < type_count; type++)
+			if (archetype.mask & (ComponentMask(1) << type))
+			{
+				const TypeInfo& info = type_info(type);
+				info.destroy(archetype.at(row, type));
+				if (row != last)
+				{
+					info.move_construct(archetype.at(row, type), archetype.at(last, type));
+					info.destroy(archetype.at(last, type));
+				}
+			}
+		if (row != last)
+		{
+			Entity moved = archetype.entity_at(last);
+			archetype.entity_at(row) = moved;
+			locations[moved.index()].row = row;
+		}
+		archetype.size--;
+	}
+
+	// Moves the entity's row to the archetype of 'mask', the components in both archetypes come along
+	void move_to(Entity e, ComponentMask mask)
+	{
+		if (e.index() >= locations.size())
+			locations.resize(e.index() + 1);
+		Location& location = locations[e.index()];
+		Archetype* from = find(e) ? location.archetype : nullptr;
+		Archetype* to = mask ? archetype_for(mask) : nullptr;
+
+		size_t row = 0;
+		if (to)
+		{
+			row = push_row(*to, e);
+			if (from)
+				for (size_t type = 0; type < type_count; type++)
+					if (from->mask & to->mask & (ComponentMask(1) << type))
+						type_info(type).move_construct(to->at(row, type), from->at(location.row, type));
+		}
+		if (from)
+			erase_row(*from, location.row);
+		location.archetype = to;
+		location.row = row;
+	}
+
+public:
+	ArchetypeStorage() {}
+
+	~ArchetypeStorage()
+	{
+		clear();
+	}
+
+	// Locations point into the archetypes
+	ArchetypeStorage(const ArchetypeStorage&) = delete;
+	ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+	// A new entity without components, see BasicRegistry::create()
+	Entity create()
+	{
+		return Entity(entity_manager.create());
+	}
+
+	// The components an entity has, as a mask
+	ComponentMask signature(Entity e)
+	{
+		Location* location = find(e);
+		return location ? location->archetype->mask : 0;
+	}
+
+	template <typename Component>
+	bool has(Entity e)
+	{
+		return (signature(e) & mask<Component>()) != 0;
+	}
+
+	template <typename Component>
+	Component& get(Entity e)
+	{
+		assert(has<Component>(e) && "Entity not contained in ECS registry");
+		Location& location = locations[e.index()];
+		return *(Component*)location.archetype->at(location.row, index_of_type<Component, Components...>::value);
+	}
+
+	// Adds a component, the entity moves to the archetype with one more column
+	template <typename Component>
+	Component& emplace(Entity e, Component c = Component())
+	{
+		assert(!has<Component>(e) && "Entity already has the component");
+		move_to(e, signature(e) | mask<Component>());
+		Location& location = locations[e.index()];
+		return *new (location.archetype->at(location.row, index_of_type<Component, Components...>::value)) Component(std::move(c));
+	}
+
+	template <typename Component>
+	void remove(Entity e)
+	{
+		if (has<Component>(e))
+			move_to(e, signature(e) & ~mask<Component>());
+	}
+
+	// Destroys the components and recycles the id, see BasicRegistry::remove_all_components_of
+	void remove_all_components_of(Entity e)
+	{
+		if (Location* location = find(e))
+		{
+			erase_row(*location->archetype, location->row);
+			location->archetype = nullptr;
+		}
+		entity_manager.destroy(e);
+	}
+
+	void clear()
+	{
+		for (auto& archetype : archetypes)
+			while (archetype->size > 0)
+			{
+				locations[archetype->entity_at(archetype->size - 1).index()].archetype = nullptr;
+				erase_row(*archetype, archetype->size - 1);
+			}
+	}
+
+	size_t archetype_count() const { return archetypes.size(); }
+
+	// Calls f(Entity, Cs&...) for every entity that has all of Cs, archetype by archetype and chunk by chunk.
+	// f must not add or remove components, that moves rows.
+	template <typename... Cs, typename Func>
+	void each(Func f)
+	{
+		constexpr ComponentMask required = mask<Cs...>();
+		for (auto& archetype : archetypes)
+		{
+			if ((archetype->mask & required) != required)
+				continue;
+			for (size_t chunk = 0; chunk * archetype->capacity < archetype->size; chunk++)
+			{
+				Entity* entities = archetype->entities(chunk);
+				std::tuple<Cs*...> columns((Cs*)archetype->column(chunk, index_of_type<Cs, Components...>::value)...);
+				size_t rows = archetype->rows_in(chunk);
+				for (size_t i = 0; i < rows; i++)
+					f(entities[i], std::get<Cs*>(columns)[i]...);
+			}
+		}
+	}
+};
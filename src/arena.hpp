@@ -0,0 +1,92 @@
+#pragma once
+
+// stlib
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// A monotonic allocator for data that lives exactly as long as a level, e.g. the strings of the HelpText components.
+// Allocating bumps an offset into the current block, nothing is freed on its own. release() drops everything at once
+// and keeps the blocks, so the next level allocates from the same memory and a level's footprint shows in bytes_used().
+class Arena
+{
+public:
+	static constexpr size_t block_size = 4 * 1024;
+
+private:
+	struct Block
+	{
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	// The block being filled and the first free byte in it, the blocks before it are full
+	size_t current = 0;
+	size_t offset = 0;
+	size_t used = 0;
+	size_t peak = 0;
+
+public:
+	Arena() {}
+
+	// The allocations point into the blocks
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// Uninitialized memory for 'bytes' bytes, valid until release()
+	void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+	{
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+		for (; current < blocks.size(); current++, offset = 0)
+		{
+			Block& block = blocks[current];
+			size_t address = (size_t)block.data.get() + offset;
+			size_t padding = (alignment - address % alignment) % alignment;
+			if (offset + padding + bytes <= block.size)
+			{
+				offset += padding + bytes;
+				used += padding + bytes;
+				peak = std::max(peak, used);
+				return (void*)(address + padding);
+			}
+		}
+		// Larger requests get a block of their own, with room to align it
+		size_t size = std::max(block_size, bytes + alignment);
+		blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+		offset = 0;
+		return allocate(bytes, alignment);
+	}
+
+	// A copy of the characters that lives in the arena, e.g. for HelpText::s
+	std::string_view copy(std::string_view s)
+	{
+		if (s.empty())
+			return std::string_view();
+		char* chars = (char*)allocate(s.size(), 1);
+		memcpy(chars, s.data(), s.size());
+		return std::string_view(chars, s.size());
+	}
+
+	// Frees all allocations at once, everything allocate() returned is dangling afterwards
+	void release()
+	{
+		current = 0;
+		offset = 0;
+		used = 0;
+	}
+
+	// Bytes handed out since the last release() including alignment padding, the most ever, and the bytes held in blocks
+	size_t bytes_used() const { return used; }
+	size_t peak_bytes() const { return peak; }
+	size_t bytes_reserved() const
+	{
+		size_t total = 0;
+		for (const Block& block : blocks)
+			total += block.size;
+		return total;
+	}
+};
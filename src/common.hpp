@@ -3,6 +3,7 @@
 // stlib
 #include <fstream> // stdout, stderr..
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
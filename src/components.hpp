@@ -10,6 +10,19 @@ struct Player
 
 };
 
+// The height the center of an entity rests at, the ground or the top of the rock the protagonist climbed.
+// Gravity pulls the entity down to here, see PhysicsSystem::step
+struct GroundHeight
+{
+	float y = 0.f;
+};
+
+// Entities that belong to the game rather than to a level, the protagonist and the gun.
+// A level transition tears down everything else and keeps these as they are, see WorldSystem::restart_game
+struct Persistent
+{
+};
+
 // Health component
 struct Health
 {
@@ -60,6 +73,19 @@ struct Gun
     float damage;
 };
 
+// Attaches an entity to another one, the child's Motion is derived from the parent's every step (see
+// PhysicsSystem::propagate_transforms). Attach with attach() in world_init.hpp, it fills in the depth.
+struct Parent
+{
+    Entity entity;
+    // Position relative to the parent, mirrored when the parent faces the other way
+    vec2 offset = { 0.f, 0.f };
+    // The child's scale when the parent faces right
+    vec2 scale = { 1.f, 1.f };
+    // Number of ancestors, children are updated after their parents
+    unsigned int depth = 0;
+};
+
 struct Sword
 {
 
@@ -152,7 +178,7 @@ struct Collision
 {
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
-	Collision(Entity& other) { this->other = other; };
+	Collision(Entity other) : other(other) {};
 };
 
 // Data structure for toggling debug mode
@@ -184,10 +210,11 @@ struct DebugComponent
 	// Note, an empty struct has size 1
 };
 
-// A struct to refer to help graphics in the ECS
+// A struct to refer to help graphics in the ECS.
+// The characters live in the registry's level_arena and are released with the level, see createHelpText
 struct HelpText
 {
-	std::string s;
+	std::string_view s;
 };
 
 // A struct to refer to items in the ECS
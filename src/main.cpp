@@ -19,10 +19,15 @@ using Clock = std::chrono::high_resolution_clock;
 // Entry point
 int main()
 {
+	// The entities of the game, declared first so that it outlives the systems working on it
+	ECSRegistry registry;
+	// The workers of the parallel loops, one pool for all systems and worlds
+	ThreadPool threads;
+
 	// Global systems
-	WorldSystem world;
-	RenderSystem renderer;
-	PhysicsSystem physics;
+	WorldSystem world(registry, threads);
+	RenderSystem renderer(registry);
+	PhysicsSystem physics(registry, threads);
 
 	// Initializing window
 	GLFWwindow* window = world.create_window();
@@ -76,9 +81,13 @@ int main()
         gameConfig.success_screen_pause_time -= elapsed_ms;
 
         if (!gameConfig.show_help && gameConfig.fail_screen_pause_time <= 0 && gameConfig.success_screen_pause_time <= 0) {
+            // The structural changes the systems record are applied in between them
+            registry.advance_tick();
             world.step(elapsed_ms);
+            registry.commands.flush();
             physics.step(elapsed_ms);
             world.handle_collisions();
+            registry.commands.flush();
         }
 		renderer.draw();
 	}
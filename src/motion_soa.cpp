@@ -0,0 +1,61 @@
+// internal
+#include "motion_soa.hpp"
+
+// The kernel processes 8 (AVX2) or 4 (SSE2) motions per iteration, the remainder and other CPUs use the scalar loop.
+// AVX2 is only used when the compiler targets it, see the WORLD_ODYSSEY_AVX2 option in CMakeLists.txt
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MOTION_SOA_SSE2
+#endif
+
+// Integrates the first n lanes of one page, the columns are 32 byte aligned
+static void integrate_page(float* px, float* py, const float* pvx, const float* pvy, const uint32_t* pfrozen, size_t n, float step_seconds)
+{
+	size_t i = 0;
+
+	// A frozen lane has all bits set, andnot zeroes its step so the position stays as is
+#if defined(__AVX2__)
+	__m256 dt = _mm256_set1_ps(step_seconds);
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 mask = _mm256_load_ps((const float*)(pfrozen + i));
+		__m256 step_x = _mm256_andnot_ps(mask, _mm256_mul_ps(_mm256_load_ps(pvx + i), dt));
+		__m256 step_y = _mm256_andnot_ps(mask, _mm256_mul_ps(_mm256_load_ps(pvy + i), dt));
+		_mm256_store_ps(px + i, _mm256_add_ps(_mm256_load_ps(px + i), step_x));
+		_mm256_store_ps(py + i, _mm256_add_ps(_mm256_load_ps(py + i), step_y));
+	}
+#elif defined(MOTION_SOA_SSE2)
+	__m128 dt = _mm_set1_ps(step_seconds);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 mask = _mm_load_ps((const float*)(pfrozen + i));
+		__m128 step_x = _mm_andnot_ps(mask, _mm_mul_ps(_mm_load_ps(pvx + i), dt));
+		__m128 step_y = _mm_andnot_ps(mask, _mm_mul_ps(_mm_load_ps(pvy + i), dt));
+		_mm_store_ps(px + i, _mm_add_ps(_mm_load_ps(px + i), step_x));
+		_mm_store_ps(py + i, _mm_add_ps(_mm_load_ps(py + i), step_y));
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		if (pfrozen[i])
+			continue;
+		px[i] += pvx[i] * step_seconds;
+		py[i] += pvy[i] * step_seconds;
+	}
+}
+
+void MotionSoA::integrate(float step_seconds, ThreadPool& pool)
+{
+	size_t page_count = (count + page_size - 1) / page_size;
+	pool.parallel_for(page_count, ThreadPool::default_grain / page_size, [&](size_t begin, size_t end) {
+		for (size_t p = begin; p < end; p++)
+		{
+			size_t first = p * page_size;
+			Page& page = *pages[p];
+			integrate_page(page.x, page.y, page.vx, page.vy, page.frozen, std::min(page_size, count - first), step_seconds);
+		}
+	});
+}
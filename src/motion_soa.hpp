@@ -0,0 +1,205 @@
+#pragma once
+
+// stlib
+#include <algorithm>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+// internal
+#include "common.hpp"
+#include "components.hpp"
+#include "thread_pool.hpp"
+
+// A vec2 whose x and y live in two separate arrays, reads convert to vec2 and writes go to the arrays.
+// Assigning to a Vec2Ref copies the values, it never re-targets the reference.
+struct Vec2Ref
+{
+	float& x;
+	float& y;
+
+	Vec2Ref(float& x, float& y) : x(x), y(y) {}
+	Vec2Ref(const Vec2Ref& other) = default;
+
+	operator vec2() const { return vec2(x, y); }
+
+	Vec2Ref& operator=(const vec2& v) { x = v.x; y = v.y; return *this; }
+	Vec2Ref& operator=(const Vec2Ref& v) { return *this = vec2(v); }
+	Vec2Ref& operator+=(const vec2& v) { x += v.x; y += v.y; return *this; }
+	Vec2Ref& operator-=(const vec2& v) { x -= v.x; y -= v.y; return *this; }
+	Vec2Ref& operator*=(const vec2& v) { x *= v.x; y *= v.y; return *this; }
+	Vec2Ref& operator/=(const vec2& v) { x /= v.x; y /= v.y; return *this; }
+	Vec2Ref& operator*=(float s) { x *= s; y *= s; return *this; }
+	Vec2Ref& operator/=(float s) { x /= s; y /= s; return *this; }
+};
+
+// glm's operators are templates and don't consider the conversion to vec2, so Vec2Ref brings its own
+inline vec2 operator-(const Vec2Ref& a) { return -vec2(a); }
+#define VEC2REF_OPERATOR(op) \
+	inline vec2 operator op(const Vec2Ref& a, const Vec2Ref& b) { return vec2(a) op vec2(b); } \
+	inline vec2 operator op(const Vec2Ref& a, const vec2& b) { return vec2(a) op b; } \
+	inline vec2 operator op(const vec2& a, const Vec2Ref& b) { return a op vec2(b); } \
+	inline vec2 operator op(const Vec2Ref& a, float b) { return vec2(a) op b; } \
+	inline vec2 operator op(float a, const Vec2Ref& b) { return a op vec2(b); }
+VEC2REF_OPERATOR(+)
+VEC2REF_OPERATOR(-)
+VEC2REF_OPERATOR(*)
+VEC2REF_OPERATOR(/)
+#undef VEC2REF_OPERATOR
+inline vec2 abs(const Vec2Ref& v) { return glm::abs(vec2(v)); }
+
+// Reference to one Motion in MotionSoA, with the same members as Motion so that most code reads the same.
+// Take it by value (MotionRef motion = registry.motions.get(e)), copy it into a Motion to get a snapshot.
+struct MotionRef
+{
+	Vec2Ref position;
+	float& angle;
+	Vec2Ref velocity;
+	Vec2Ref scale;
+
+	MotionRef(float& x, float& y, float& angle, float& vx, float& vy, float& sx, float& sy)
+		: position(x, y), angle(angle), velocity(vx, vy), scale(sx, sy) {}
+	MotionRef(const MotionRef& other) = default;
+
+	operator Motion() const
+	{
+		Motion m;
+		m.position = position;
+		m.angle = angle;
+		m.velocity = velocity;
+		m.scale = scale;
+		return m;
+	}
+
+	MotionRef& operator=(const Motion& m)
+	{
+		position = m.position;
+		angle = m.angle;
+		velocity = m.velocity;
+		scale = m.scale;
+		return *this;
+	}
+	MotionRef& operator=(const MotionRef& other) { return *this = Motion(other); }
+};
+
+// Exchanges the values the references point to, for ComponentContainer::swap_elements
+inline void swap(MotionRef a, MotionRef b)
+{
+	Motion tmp = a;
+	a = b;
+	b = tmp;
+}
+
+// Motion stored as a structure of arrays, one 32 byte aligned column per float, for the integration kernel.
+// The columns are split into fixed-size pages, growing adds a page and never moves the motions already stored,
+// so a MotionRef stays valid while other motions are inserted (only remove() moves the last motion into the hole).
+// registry.motions keeps that guarantee, the renderables group requires motions without owning them.
+// Provides the subset of the std::vector interface ComponentContainer uses, with MotionRef as the reference type.
+class MotionSoA
+{
+public:
+	// A multiple of the SIMD width so that every page starts a new batch
+	static constexpr size_t page_size = 256;
+
+private:
+	struct Page
+	{
+		alignas(32) float x[page_size];
+		alignas(32) float y[page_size];
+		alignas(32) float vx[page_size];
+		alignas(32) float vy[page_size];
+		alignas(32) float sx[page_size];
+		alignas(32) float sy[page_size];
+		alignas(32) float angle[page_size];
+		// Per lane, all bits set for motions that don't move in integrate()
+		alignas(32) uint32_t frozen[page_size];
+	};
+	std::vector<std::unique_ptr<Page>> pages;
+	size_t count = 0;
+
+	Page& page_of(size_t i) { return *pages[i / page_size]; }
+
+public:
+	typedef Motion value_type;
+	typedef MotionRef reference;
+
+	// What try_get() returns, a nullable handle to one element
+	class pointer
+	{
+		MotionSoA* storage = nullptr;
+		size_t i = 0;
+	public:
+		pointer() {}
+		pointer(MotionSoA* storage, size_t i) : storage(storage), i(i) {}
+		explicit operator bool() const { return storage != nullptr; }
+		bool operator==(std::nullptr_t) const { return storage == nullptr; }
+		bool operator!=(std::nullptr_t) const { return storage != nullptr; }
+		MotionRef operator*() const { return (*storage)[i]; }
+	};
+
+	class iterator
+	{
+		MotionSoA* storage;
+		size_t i;
+	public:
+		iterator(MotionSoA* storage, size_t i) : storage(storage), i(i) {}
+		MotionRef operator*() const { return (*storage)[i]; }
+		iterator& operator++() { i++; return *this; }
+		bool operator==(const iterator& other) const { return i == other.i; }
+		bool operator!=(const iterator& other) const { return i != other.i; }
+	};
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	size_t capacity() const { return pages.size() * page_size; }
+	size_t bytes() const { return pages.size() * sizeof(Page) + pages.capacity() * sizeof(pages[0]); }
+
+	MotionRef operator[](size_t i)
+	{
+		Page& page = page_of(i);
+		size_t j = i % page_size;
+		return MotionRef(page.x[j], page.y[j], page.angle[j], page.vx[j], page.vy[j], page.sx[j], page.sy[j]);
+	}
+	MotionRef back() { return (*this)[count - 1]; }
+	pointer address(size_t i) { return pointer(this, i); }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, count); }
+
+	void push_back(const Motion& m)
+	{
+		reserve(count + 1);
+		(*this)[count++] = m;
+		page_of(count - 1).frozen[(count - 1) % page_size] = 0;
+	}
+
+	void pop_back() { count--; }
+
+	// The pages stay allocated for the next round of motions
+	void clear() { count = 0; }
+
+	void reserve(size_t n)
+	{
+		while (pages.size() * page_size < n)
+			pages.emplace_back(new Page());
+	}
+
+	// The frozen lanes are skipped by integrate(), the mask is not kept when elements move so set it right before integrating
+	void clear_frozen()
+	{
+		for (size_t first = 0; first < count; first += page_size)
+			std::fill_n(page_of(first).frozen, page_size, 0u);
+	}
+	void set_frozen(size_t i) { page_of(i).frozen[i % page_size] = ~0u; }
+
+	// position += velocity * step_seconds for every motion that isn't frozen, see motion_soa.cpp.
+	// The pages are independent, large counts are split into runs of pages for the pool.
+	void integrate(float step_seconds, ThreadPool& pool);
+};
+
+// ComponentContainer<Motion> stores its components in a MotionSoA
+template <>
+struct component_storage<Motion>
+{
+	typedef MotionSoA type;
+};
@@ -30,62 +30,76 @@ bool collides(const Motion& motion1, const Motion& motion2)
 	return motion1Top < motion2Bottom && motion2Top < motion1Bottom && motion1Left < motion2Right && motion2Left < motion1Right;
 }
 
+// WorldSystem::handle_collisions only acts on pairs where both entities have one of these components. The others
+// (backgrounds, foregrounds, help texts, health bars, the gun) are left out of the broadphase.
+static constexpr ComponentMask collider_mask = ECSRegistry::mask<Player, Enemy, Boss, ForestBoss, DesertBoss, IceBoss,
+	Deadly, Obstacle, Item, Bullet, Grenade, Snowball, Tornado>();
+
+// The parents container is kept sorted by depth, so a single pass over it visits every parent before its children
+// and each child reads the transform its parent got earlier in the same pass. Attaching rarely changes the order,
+// the sort only runs when an attach broke it.
+void PhysicsSystem::propagate_transforms()
+{
+	auto& parents = registry.parents;
+	bool sorted = true;
+	for (size_t i = 1; i < parents.components.size() && sorted; i++)
+		sorted = parents.components[i - 1].depth <= parents.components[i].depth;
+	if (!sorted)
+		parents.sort([&](Entity a, Entity b) { return parents.get(a).depth < parents.get(b).depth; });
+
+	for (size_t i = 0; i < parents.components.size(); i++)
+	{
+		const Parent& parent = parents.components[i];
+		Entity child = parents.entities[i];
+		// A child whose parent is gone keeps its last transform
+		if (!registry.motions.has(parent.entity) || !registry.motions.has(child))
+			continue;
+		follow_parent(parent, registry.motions.get(parent.entity), registry.motions.get(child));
+	}
+}
+
 void PhysicsSystem::step(float elapsed_ms)
 {
 
     // Change the velocity_y and angle of grenade
-    for (Entity grenadeE : registry.grenades.entities) {
-        Grenade grenade = registry.grenades.get(grenadeE);
+    registry.view<Grenade, Motion>().each([&](Entity, Grenade& grenade, MotionRef grenadeMotion) {
         float vely = grenade.deltaVy * (elapsed_ms / 1000);
-        Motion& grenadeMotion = registry.motions.get(grenadeE);
         grenadeMotion.velocity.y += vely;
         grenadeMotion.angle += -30 * (elapsed_ms / 1000) * (2 * M_PI / 180);
-    }
+    });
 
-	for (Entity snowballE : registry.snowballs.entities) {
-		Snowball snowball = registry.snowballs.get(snowballE);
+	registry.view<Snowball, Motion>().each([&](Entity, Snowball& snowball, MotionRef snowballMotion) {
 		float vely = snowball.deltaVy * (elapsed_ms / 1000);
-		Motion& snowballMotion = registry.motions.get(snowballE);
 		snowballMotion.velocity.y += vely;
 		snowballMotion.angle += -30 * (elapsed_ms / 1000) * (2 * M_PI / 180);
-	}
+	});
 
 
 	// Move bug based on how much time has passed, this is to (partially) avoid
 	// having entities move at different speed based on the machine.
+	// Dying entities don't move, they are marked as frozen lanes instead of looking up the death timer per motion
 	auto& motion_registry = registry.motions;
-	for(uint i = 0; i< motion_registry.size(); i++)
-	{
-		// !!! TODO A1: update motion.position based on step_seconds and motion.velocity
-		Motion& motion = motion_registry.components[i];
-		Entity entity = motion_registry.entities[i];
-		if (!registry.deathTimers.has(entity)) {
-			float step_seconds = elapsed_ms / 1000.f;
-
-			motion.position += motion.velocity * (step_seconds);
-		}
-	}
+	motion_registry.components.clear_frozen();
+	for (Entity entity : registry.deathTimers.entities)
+		if (motion_registry.has(entity))
+			motion_registry.components.set_frozen(motion_registry.index_of(entity));
+	float step_seconds = elapsed_ms / 1000.f;
+	motion_registry.components.integrate(step_seconds, threads);
 
     // Animate Item y position
-    static unsigned int item_animation_timer = 0;
     item_animation_timer++;
     float offset = 0;
     for(Entity item : registry.items.entities) {
-        Motion& motion = registry.motions.get(item);
+        MotionRef motion = registry.motions.get(item);
         motion.position.y = motion.position.y + sinf((offset + item_animation_timer)*0.2f) * 0.7;
         offset += M_PI;
     }
 
-    for (Entity gun : registry.guns.entities) {
-        Motion& gunMotion = registry.motions.get(gun);
-        Entity protagonist = registry.players.entities[0];
-        Motion playerMotion = registry.motions.get(protagonist);
-        gunMotion.position = playerMotion.position;
-        gunMotion.scale = (playerMotion.scale / abs(playerMotion.scale)) * abs(gunMotion.scale);
-    }
+    // Attached entities (the gun) follow their parents
+    propagate_transforms();
 
     for (Entity bullet : registry.bullets.entities) {
-        Motion& bulletMotion = registry.motions.get(bullet);
+        MotionRef bulletMotion = registry.motions.get(bullet);
         bulletMotion.velocity = (bulletMotion.scale / abs(bulletMotion.scale)) * vec2({400.f, 0.0f});
     }
 
@@ -94,25 +108,31 @@ void PhysicsSystem::step(float elapsed_ms)
 	// DON'T WORRY ABOUT THIS UNTIL ASSIGNMENT 2
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
-	// Check for collisions between all moving entities
+	// Check for collisions between the moving entities that take part in one, see collider_mask.
+	// The grid pairs up the entities that share a cell, sorted by motion index, so the collisions come in the
+	// order of the all pairs loop it replaces
     ComponentContainer<Motion> &motion_container = registry.motions;
+	broadphase.clear();
 	for(uint i = 0; i<motion_container.components.size(); i++)
 	{
-		Motion& motion_i = motion_container.components[i];
-		Entity entity_i = motion_container.entities[i];
-		
-		// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-		for(uint j = i+1; j<motion_container.components.size(); j++)
+		if (!registry.has_any(motion_container.entities[i], collider_mask))
+			continue;
+		Motion motion = motion_container.components[i];
+		vec2 half_size = get_bounding_box(motion) / 2.f;
+		broadphase.insert(i, motion.position.x - half_size.x, motion.position.y - half_size.y, motion.position.x + half_size.x, motion.position.y + half_size.y);
+	}
+	for (const std::pair<uint32_t, uint32_t>& pair : broadphase.candidate_pairs())
+	{
+		Motion motion_i = motion_container.components[pair.first];
+		Motion motion_j = motion_container.components[pair.second];
+		if (collides(motion_i, motion_j))
 		{
-			Motion& motion_j = motion_container.components[j];
-			if (collides(motion_i, motion_j))
-			{
-				Entity entity_j = motion_container.entities[j];
-				// Create a collisions event
-				// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-				registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-				registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-			}
+			Entity entity_i = motion_container.entities[pair.first];
+			Entity entity_j = motion_container.entities[pair.second];
+			// Create a collisions event
+			// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+			registry.collisions.emplace_with_duplicates(entity_i, entity_j);
+			registry.collisions.emplace_with_duplicates(entity_j, entity_i);
 		}
 	}
 
@@ -124,7 +144,7 @@ void PhysicsSystem::step(float elapsed_ms)
     // Keep protagonist within the boundaries of the window
     for (Entity player : registry.players.entities) {
         if (registry.motions.has(player)) {
-            Motion& playerMotion = registry.motions.get(player);
+            MotionRef playerMotion = registry.motions.get(player);
             // Check for player collision with window boundary
             vec2 playerBB = get_bounding_box(playerMotion);
 			/*
@@ -147,13 +167,14 @@ void PhysicsSystem::step(float elapsed_ms)
             }
 
 			//apply gravity
-			if (playerMotion.position.y < protagonist_center_pos_y) {
+			float ground_y = registry.groundHeights.get(player).y;
+			if (playerMotion.position.y < ground_y) {
 				playerMotion.velocity.y += 12.0f;
 			} else {
 				playerMotion.velocity.y = 0.f;
 			}
-			if (playerMotion.position.y > protagonist_center_pos_y) {
-				playerMotion.position.y = protagonist_center_pos_y;
+			if (playerMotion.position.y > ground_y) {
+				playerMotion.position.y = ground_y;
 			}
         }
     }
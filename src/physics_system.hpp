@@ -4,6 +4,7 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "spatial_hash.hpp"
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
@@ -11,7 +12,21 @@ class PhysicsSystem
 public:
 	void step(float elapsed_ms);
 
-	PhysicsSystem()
+	// The motions are integrated on 'threads'
+	PhysicsSystem(ECSRegistry& registry, ThreadPool& threads) : registry(registry), threads(threads)
 	{
 	}
+
+private:
+	// Moves every entity with a Parent along with its parent, parents first
+	void propagate_transforms();
+
+	ECSRegistry& registry;
+	ThreadPool& threads;
+
+	// Steps so far, the items bob along a sine of it
+	unsigned int item_animation_timer = 0;
+
+	// The colliders of the current step by the cells they cover, the cells are about the size of an enemy
+	SpatialHashGrid broadphase{ 128.f };
 };
\ No newline at end of file
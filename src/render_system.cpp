@@ -8,11 +8,11 @@
 #include "tiny_ecs_registry.hpp"
 
 void RenderSystem::drawTexturedMesh(Entity entity,
-									const mat3 &projection)
+									const RenderRequest &render_request,
+									const Motion &motion,
+									const mat3 &projection,
+									bool request_bound)
 {
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-	Motion &motion = registry.motions.get(entity);
 	// Transformation code, see Rendering and Transformation in the template
 	// specification for more info Incrementally updates transformation matrix,
 	// thus ORDER IS IMPORTANT
@@ -23,88 +23,89 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 	// !!! TODO A1: add rotation to the chain of transformations, mind the order
 	// of transformations
 
-	assert(registry.renderRequests.has(entity));
-	const RenderRequest &render_request = registry.renderRequests.get(entity);
-
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
 
-	// Setting shaders
-	glUseProgram(program);
-	gl_has_errors();
-
-	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
-
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	gl_has_errors();
-
-	// Input data location as in the vertex buffer
-	if (render_request.used_effect == EFFECT_ASSET_ID::TEXTURED)
+	// Set up the program, buffers, vertex layout and texture unless the previous entity already did for the same request
+	if (!request_bound)
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
+		// Setting shaders
+		glUseProgram(program);
 		gl_has_errors();
-		assert(in_texcoord_loc >= 0);
 
-		glEnableVertexAttribArray(in_position_loc);
+		assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
+		const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
+		const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
 
+		// Setting vertex and index buffers
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 		gl_has_errors();
 
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(TexturedVertex), (void *)0);
-		gl_has_errors();
+		// Input data location as in the vertex buffer
+		if (render_request.used_effect == EFFECT_ASSET_ID::TEXTURED)
+		{
+			GLint in_position_loc = glGetAttribLocation(program, "in_position");
+			GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
+			gl_has_errors();
+			assert(in_texcoord_loc >= 0);
 
-		glEnableVertexAttribArray(in_texcoord_loc);
-		glVertexAttribPointer(
-			in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-			(void *)sizeof(
-				vec3)); // note the stride to skip the preceeding vertex position
+			glEnableVertexAttribArray(in_position_loc);
 
-		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
-		gl_has_errors();
+			gl_has_errors();
 
-		assert(registry.renderRequests.has(entity));
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+			glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
+								  sizeof(TexturedVertex), (void *)0);
+			gl_has_errors();
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
-		gl_has_errors();
-	}
-	else if (render_request.used_effect == EFFECT_ASSET_ID::PROTAGONIST || render_request.used_effect == EFFECT_ASSET_ID::EGG)
-	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_color_loc = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
+			glEnableVertexAttribArray(in_texcoord_loc);
+			glVertexAttribPointer(
+				in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
+				(void *)sizeof(
+					vec3)); // note the stride to skip the preceeding vertex position
 
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)0);
-		gl_has_errors();
+			// Enabling and binding texture to slot 0
+			glActiveTexture(GL_TEXTURE0);
+			gl_has_errors();
 
-		glEnableVertexAttribArray(in_color_loc);
-		glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)sizeof(vec3));
-		gl_has_errors();
+			GLuint texture_id =
+				texture_gl_handles[(GLuint)render_request.used_texture];
 
-		if (render_request.used_effect == EFFECT_ASSET_ID::PROTAGONIST)
+			glBindTexture(GL_TEXTURE_2D, texture_id);
+			gl_has_errors();
+		}
+		else if (render_request.used_effect == EFFECT_ASSET_ID::PROTAGONIST || render_request.used_effect == EFFECT_ASSET_ID::EGG)
 		{
+			GLint in_position_loc = glGetAttribLocation(program, "in_position");
+			GLint in_color_loc = glGetAttribLocation(program, "in_color");
+			gl_has_errors();
+
+			glEnableVertexAttribArray(in_position_loc);
+			glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
+								  sizeof(ColoredVertex), (void *)0);
 			gl_has_errors();
+
+			glEnableVertexAttribArray(in_color_loc);
+			glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
+								  sizeof(ColoredVertex), (void *)sizeof(vec3));
+			gl_has_errors();
+
+			if (render_request.used_effect == EFFECT_ASSET_ID::PROTAGONIST)
+			{
+				gl_has_errors();
+			}
+		}
+		else
+		{
+			assert(false && "Type of render request not supported");
 		}
-	}
-	else
-	{
-		assert(false && "Type of render request not supported");
 	}
 
 	// Getting uniform locations for glUniform* calls
 	GLint color_uloc = glGetUniformLocation(program, "fcolor");
-	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
+	const vec3* entity_color = registry.colors.try_get(entity);
+	const vec3 color = entity_color ? *entity_color : vec3(1);
 	glUniform3fv(color_uloc, 1, (float *)&color);
 	gl_has_errors();
 
@@ -330,14 +331,13 @@ void RenderSystem::draw()
 	mat3 projection_2D = createProjectionMatrix();
 	// Draw all textured meshes that have a position and size component
 	glBindVertexArray(vao);
-	for (Entity entity : registry.renderRequests.entities)
-	{
-		if (!registry.motions.has(entity))
-			continue;
-		// Note, its not very efficient to access elements indirectly via the entity
-		// albeit iterating through all Sprites in sequence. A good point to optimize
-		drawTexturedMesh(entity, projection_2D);
-	}
+	// The renderables group walks the packed renderRequests and looks up each motion, the group order is the draw order.
+	// Consecutive entities with the same shared render request reuse the program, buffers and texture of the first.
+	uint32_t bound_request = ~0u;
+	registry.renderables.each([&](Entity entity, SharedRef<RenderRequest> render_request, MotionRef motion) {
+		drawTexturedMesh(entity, render_request, motion, projection_2D, render_request.value_index() == bound_request);
+		bound_request = render_request.value_index();
+	});
 
 	gl_has_errors();
 
@@ -367,7 +367,7 @@ mat3 RenderSystem::createProjectionMatrix()
 {
 
 	Entity& player = registry.players.entities[0];
-	Motion& playerMotion = registry.motions.get(player);
+	MotionRef playerMotion = registry.motions.get(player);
 
 	// Fake projection matrix, scales with respect to window coordinates
 	float left = playerMotion.position.x - static_cast<float>(window_width_px) / 2;
@@ -443,13 +443,13 @@ void RenderSystem::drawHelpText()
             continue;
 
         HelpText& text = registry.helpTexts.get(entity);
-        Motion& motion = registry.motions.get(entity);
+        MotionRef motion = registry.motions.get(entity);
         mat4 trans = mat4(1.0f);
         renderText(text.s, motion.position.x, window_height_px - motion.position.y, 0.5f, glm::vec3(1.0f, 0.0f, 0.0f), trans);
     }
 }
 
-void RenderSystem::renderText(const std::string& text, float x, float y,
+void RenderSystem::renderText(std::string_view text, float x, float y,
                               float scale, const glm::vec3& color,
                               const glm::mat4& trans) {
 
@@ -476,7 +476,7 @@ void RenderSystem::renderText(const std::string& text, float x, float y,
     glBindVertexArray(m_font_VAO);
 
     // iterate through all characters
-    std::string::const_iterator c;
+    std::string_view::const_iterator c;
     for (c = text.begin(); c != text.end(); c++)
     {
         Character ch = m_ftCharacters[*c];
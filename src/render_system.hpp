@@ -6,6 +6,7 @@
 #include "common.hpp"
 #include "components.hpp"
 #include "tiny_ecs.hpp"
+#include "tiny_ecs_registry.hpp"
 
 
 // fonts
@@ -124,6 +125,9 @@ class RenderSystem {
 	GLuint m_font_VBO;
 
 public:
+	// Draws the entities of 'registry'
+	RenderSystem(ECSRegistry& registry) : registry(registry) {}
+
 	bool show_help;
 	// Initialize the window
 	bool init(GLFWwindow* window);
@@ -161,7 +165,7 @@ public:
 
     void renderHelp();
 
-    void renderText(const std::string& text, float x, float y, float scale, const glm::vec3& color, const glm::mat4& trans);
+    void renderText(std::string_view text, float x, float y, float scale, const glm::vec3& color, const glm::mat4& trans);
 
     bool fontInit(const std::string& font_filename, unsigned int font_default_size);
 
@@ -173,13 +177,16 @@ public:
 
 private:
 	// Internal drawing functions for each entity type
-	void drawTexturedMesh(Entity entity, const mat3& projection);
+	// request_bound skips the state setup when the previous entity had the same render request
+	void drawTexturedMesh(Entity entity, const RenderRequest& render_request, const Motion& motion, const mat3& projection, bool request_bound);
 	void drawToScreen();
     void drawInventory();
 
 	// Window handle
 	GLFWwindow* window;
 
+	ECSRegistry& registry;
+
 	// Screen texture handles
 	GLuint frame_buffer;
 	GLuint off_screen_render_buffer_color;
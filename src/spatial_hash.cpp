@@ -0,0 +1,123 @@
+// internal
+#include "spatial_hash.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+
+void SpatialHashGrid::clear()
+{
+	boxes.clear();
+	entries.clear();
+	large.clear();
+	max_id = 0;
+}
+
+int32_t SpatialHashGrid::cell_of(float coordinate) const
+{
+	// Far away or broken positions end up in the outermost cells instead of overflowing the cast
+	const float limit = 1 << 20;
+	float cell = std::floor(coordinate / cell_size);
+	if (!(cell > -limit))
+		return -(int32_t)limit;
+	return (int32_t)std::min(cell, limit);
+}
+
+uint32_t SpatialHashGrid::hash(int32_t cell_x, int32_t cell_y)
+{
+	return ((uint32_t)cell_x * 73856093u) ^ ((uint32_t)cell_y * 19349663u);
+}
+
+bool SpatialHashGrid::overlap(const Box& a, const Box& b)
+{
+	return a.min_x <= b.max_x && b.min_x <= a.max_x && a.min_y <= b.max_y && b.min_y <= a.max_y;
+}
+
+void SpatialHashGrid::insert(uint32_t id, float min_x, float min_y, float max_x, float max_y)
+{
+	Box box = { id, min_x, min_y, max_x, max_y, cell_of(min_x), cell_of(min_y), false };
+	int32_t last_x = cell_of(max_x);
+	int32_t last_y = cell_of(max_y);
+	uint32_t index = (uint32_t)boxes.size();
+	max_id = std::max(max_id, id);
+	box.large = (int64_t)(last_x - box.cell_x + 1) * (last_y - box.cell_y + 1) > max_cells_per_box;
+	boxes.push_back(box);
+
+	if (box.large)
+	{
+		large.push_back(index);
+		return;
+	}
+	for (int32_t y = box.cell_y; y <= last_y; y++)
+		for (int32_t x = box.cell_x; x <= last_x; x++)
+			entries.push_back({ index, x, y });
+}
+
+const std::vector<std::pair<uint32_t, uint32_t>>& SpatialHashGrid::candidate_pairs()
+{
+	unsorted.clear();
+
+	// About two buckets per entry keeps the unrelated cells sharing a bucket rare
+	size_t bucket_count = 64;
+	while (bucket_count < 2 * entries.size())
+		bucket_count *= 2;
+	size_t mask = bucket_count - 1;
+
+	bucket_starts.assign(bucket_count + 1, 0);
+	for (const Entry& entry : entries)
+		bucket_starts[(hash(entry.cell_x, entry.cell_y) & mask) + 1]++;
+	for (size_t b = 0; b < bucket_count; b++)
+		bucket_starts[b + 1] += bucket_starts[b];
+	sorted.resize(entries.size());
+	for (const Entry& entry : entries)
+		sorted[bucket_starts[hash(entry.cell_x, entry.cell_y) & mask]++] = entry;
+	// The fill advanced every start to the start of the next bucket
+	for (size_t b = bucket_count; b > 0; b--)
+		bucket_starts[b] = bucket_starts[b - 1];
+	bucket_starts[0] = 0;
+
+	for (size_t bucket = 0; bucket < bucket_count; bucket++)
+	{
+		for (uint32_t i = bucket_starts[bucket]; i < bucket_starts[bucket + 1]; i++)
+			for (uint32_t j = i + 1; j < bucket_starts[bucket + 1]; j++)
+			{
+				const Entry& e1 = sorted[i];
+				const Entry& e2 = sorted[j];
+				if (e1.cell_x != e2.cell_x || e1.cell_y != e2.cell_y)
+					continue;
+				// Two boxes share every cell of their overlap, only the first of those cells reports them
+				const Box& a = boxes[e1.box];
+				const Box& b = boxes[e2.box];
+				if (e1.cell_x != std::max(a.cell_x, b.cell_x) || e1.cell_y != std::max(a.cell_y, b.cell_y))
+					continue;
+				unsorted.emplace_back(std::min(a.id, b.id), std::max(a.id, b.id));
+			}
+	}
+
+	// The large boxes are few (backgrounds, platforms), they are tested against every box
+	for (uint32_t l : large)
+	{
+		const Box& a = boxes[l];
+		for (uint32_t other = 0; other < boxes.size(); other++)
+		{
+			const Box& b = boxes[other];
+			// A pair of large boxes is reported by the one inserted later
+			if (other == l || (b.large && other > l) || !overlap(a, b))
+				continue;
+			unsorted.emplace_back(std::min(a.id, b.id), std::max(a.id, b.id));
+		}
+	}
+
+	// Counting sort by the first id, then each run of the same first id (a box and its few neighbours) by the second
+	first_starts.assign((size_t)max_id + 2, 0);
+	for (const std::pair<uint32_t, uint32_t>& pair : unsorted)
+		first_starts[pair.first + 1]++;
+	for (size_t id = 0; id <= max_id; id++)
+		first_starts[id + 1] += first_starts[id];
+	pairs.resize(unsorted.size());
+	for (const std::pair<uint32_t, uint32_t>& pair : unsorted)
+		pairs[first_starts[pair.first]++] = pair;
+	for (size_t id = 0, begin = 0; id <= max_id; begin = first_starts[id++])
+		std::sort(pairs.begin() + begin, pairs.begin() + first_starts[id]);
+	return pairs;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// stlib
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// Broadphase for the collision test, a uniform grid of square cells stored as a hash table so that it is unbounded.
+// Every step the boxes are inserted again, candidate_pairs() then pairs up the boxes that share a cell instead of
+// testing all against all. The vectors keep their capacity, so a level that stays the same size stops allocating.
+class SpatialHashGrid
+{
+public:
+	// A box covering more cells than this isn't put in the cells, it is paired with every box it overlaps instead
+	static constexpr int max_cells_per_box = 16;
+
+	explicit SpatialHashGrid(float cell_size) : cell_size(cell_size) {}
+
+	// Removes all boxes
+	void clear();
+
+	// Adds a box, the id is chosen by the caller (e.g. the index of its Motion) and comes back in the pairs
+	void insert(uint32_t id, float min_x, float min_y, float max_x, float max_y);
+
+	// The pairs (a, b) with a < b of boxes that share a cell, each pair once, sorted by a and then b.
+	// Boxes in the same cell don't have to overlap, the caller runs the exact test. Valid until the next clear() or insert().
+	const std::vector<std::pair<uint32_t, uint32_t>>& candidate_pairs();
+
+	size_t size() const { return boxes.size(); }
+
+private:
+	struct Box
+	{
+		uint32_t id;
+		float min_x, min_y, max_x, max_y;
+		// The first cell the box covers
+		int32_t cell_x, cell_y;
+		// Covers more than max_cells_per_box cells, see large
+		bool large;
+	};
+	// One per cell a box covers, grouped by the bucket of the cell in candidate_pairs()
+	struct Entry
+	{
+		uint32_t box;
+		int32_t cell_x, cell_y;
+	};
+
+	float cell_size;
+	std::vector<Box> boxes;
+	std::vector<Entry> entries;
+	// Boxes over max_cells_per_box, indices into boxes
+	std::vector<uint32_t> large;
+
+	// Counting sort of the entries by bucket, bucket_starts[b] is the first entry of bucket b
+	std::vector<Entry> sorted;
+	std::vector<uint32_t> bucket_starts;
+	// The pairs as found and sorted by id, first_starts[id] is where the pairs of the first id 'id' go
+	std::vector<std::pair<uint32_t, uint32_t>> unsorted;
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+	std::vector<uint32_t> first_starts;
+	uint32_t max_id = 0;
+
+	int32_t cell_of(float coordinate) const;
+	static uint32_t hash(int32_t cell_x, int32_t cell_y);
+	static bool overlap(const Box& a, const Box& b);
+};
@@ -0,0 +1,105 @@
+// internal
+#include "thread_pool.hpp"
+
+// stlib
+#include <algorithm>
+
+// Set on the workers and on a thread that is inside run(), a loop started there runs inline instead of waiting on itself
+static thread_local bool inside_pool = false;
+
+size_t ThreadPool::default_workers()
+{
+	unsigned int cores = std::thread::hardware_concurrency();
+	return cores > 1 ? cores - 1 : 0;
+}
+
+ThreadPool::ThreadPool(size_t worker_count)
+{
+	workers.reserve(worker_count);
+	for (size_t i = 0; i < worker_count; i++)
+		workers.emplace_back([this]() { work(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	job_posted.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::run(size_t count, size_t grain, ChunkFunc chunk, void* context)
+{
+	grain = std::max<size_t>(grain, 1);
+	if (count == 0)
+		return;
+	if (count <= grain || workers.empty() || inside_pool)
+	{
+		chunk(context, 0, count);
+		return;
+	}
+
+	std::lock_guard<std::mutex> one_at_a_time(run_mutex);
+	{
+		// A worker that woke up late may still be looking at the previous job
+		std::unique_lock<std::mutex> lock(mutex);
+		job_done.wait(lock, [this]() { return active_workers == 0; });
+		job.chunk = chunk;
+		job.context = context;
+		job.count = count;
+		job.grain = grain;
+		job.chunks = (count + grain - 1) / grain;
+		next_chunk = 0;
+		pending_chunks = job.chunks;
+		generation++;
+	}
+	job_posted.notify_all();
+
+	inside_pool = true;
+	process(job);
+	inside_pool = false;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	job_done.wait(lock, [this]() { return pending_chunks == 0 && active_workers == 0; });
+}
+
+void ThreadPool::work()
+{
+	inside_pool = true;
+	size_t seen = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		job_posted.wait(lock, [&]() { return stopping || generation != seen; });
+		if (stopping)
+			return;
+		seen = generation;
+		Job current = job;
+		active_workers++;
+		lock.unlock();
+
+		process(current);
+
+		lock.lock();
+		if (--active_workers == 0)
+			job_done.notify_all();
+	}
+}
+
+void ThreadPool::process(const Job& current)
+{
+	for (size_t i = next_chunk++; i < current.chunks; i = next_chunk++)
+	{
+		size_t begin = i * current.grain;
+		current.chunk(current.context, begin, std::min(current.count, begin + current.grain));
+		if (--pending_chunks == 0)
+		{
+			// Under the lock so that run() can't miss the notification between its check and its wait
+			std::lock_guard<std::mutex> lock(mutex);
+			job_done.notify_all();
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// stlib
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for data-parallel loops, see ComponentContainer::parallel_for_each and View::parallel_each.
+// parallel_for() splits [0, count) into chunks of 'grain' indices and returns when all of them ran, the calling thread
+// takes chunks as well. Loops of at most one chunk, and loops started from inside a chunk, run on the calling thread.
+class ThreadPool
+{
+public:
+	// Below this many elements the cost of waking the workers is larger than the loop
+	static constexpr size_t default_grain = 1024;
+
+	// One worker per core besides the calling thread
+	explicit ThreadPool(size_t worker_count = default_workers());
+	~ThreadPool();
+
+	// The workers wait on this pool
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// The threads a loop runs on, the calling one included
+	size_t threads() const { return workers.size() + 1; }
+
+	// Calls f(begin, end) for consecutive ranges that cover [0, count), in no particular order and possibly at the same time
+	template <typename Func>
+	void parallel_for(size_t count, size_t grain, Func f)
+	{
+		run(count, grain, [](void* context, size_t begin, size_t end) { (*(Func*)context)(begin, end); }, &f);
+	}
+
+	static size_t default_workers();
+
+private:
+	typedef void (*ChunkFunc)(void* context, size_t begin, size_t end);
+
+	// The loop being run, written by run() while no worker is active
+	struct Job
+	{
+		ChunkFunc chunk = nullptr;
+		void* context = nullptr;
+		size_t count = 0;
+		size_t grain = 1;
+		size_t chunks = 0;
+	};
+	Job job;
+	std::atomic<size_t> next_chunk{ 0 };
+	std::atomic<size_t> pending_chunks{ 0 };
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	// Workers wait for a new generation, run() for the last chunk and the workers to go idle
+	std::condition_variable job_posted;
+	std::condition_variable job_done;
+	size_t generation = 0;
+	size_t active_workers = 0;
+	bool stopping = false;
+	// One loop at a time
+	std::mutex run_mutex;
+
+	void run(size_t count, size_t grain, ChunkFunc chunk, void* context);
+	void work();
+	void process(const Job& job);
+};
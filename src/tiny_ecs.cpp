@@ -1,5 +1,44 @@
 // internal
 #include "tiny_ecs.hpp"
 
+// stlib
+#include <stdlib.h>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
 // All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+// The entity ids are owned by the EntityManager of each registry, which is defined inline in the header
+
+std::string type_name(const std::type_info& type)
+{
+#ifdef __GNUG__
+	// GCC and Clang mangle typeid names, MSVC's are readable already ("struct Motion")
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+	if (status == 0 && demangled)
+	{
+		std::string name = demangled;
+		free(demangled);
+		return name;
+	}
+#endif
+	return type.name();
+}
+
+bool write_stats_csv(const std::vector<ContainerStats>& stats, uint32_t tick, const char* path)
+{
+	FILE* file = fopen(path, "a");
+	if (!file)
+		return false;
+	fseek(file, 0, SEEK_END);
+	if (ftell(file) == 0)
+		fprintf(file, "tick,container,size,capacity,peak_size,component_bytes,entity_bytes,index_bytes,inserts,removes\n");
+	for (const ContainerStats& s : stats)
+		// Quoted, template names like glm::vec<3, float, ...> contain commas
+		fprintf(file, "%u,\"%s\",%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n", tick, s.name.c_str(), s.size, s.capacity, s.peak_size,
+			s.component_bytes, s.entity_bytes, s.index_bytes, s.inserts, s.removes);
+	bool written = !ferror(file);
+	fclose(file);
+	return written;
+}
@@ -2,86 +2,812 @@
 
 #include <algorithm>
 #include <vector>
-#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <new>
 #include <set>
+#include <tuple>
+#include <type_traits>
 #include <functional>
 #include <typeindex>
 #include <assert.h>
+#include <stdio.h>
+#include <typeinfo>
+#include <stdint.h>
+#include <string.h>
+#include <string>
 
-// Unique identifyer for all entities
+// internal
+#include "thread_pool.hpp"
+
+// Hands out entity ids and recycles the ones of destroyed entities.
+// An id packs the slot index in the low bits and a generation in the high bits. Destroying an entity
+// bumps the generation of its slot, so handles that are still held to the old entity stop matching
+// once the slot is reused. Index 0 is never handed out, id 0 is the null entity.
+class EntityManager
+{
+	std::vector<unsigned int> generations; // current generation of every slot
+	std::deque<unsigned int> free_indices; // FIFO, so a slot is reused as late as possible and generations wrap slowly
+public:
+	static const unsigned int index_bits = 20; // up to ~1M entities alive at the same time
+	static const unsigned int index_mask = (1u << index_bits) - 1;
+	static const unsigned int generation_mask = (1u << (32 - index_bits)) - 1;
+
+	static unsigned int index_of(unsigned int id) { return id & index_mask; }
+	static unsigned int generation_of(unsigned int id) { return id >> index_bits; }
+
+	EntityManager() : generations(1, 0) {}
+
+	unsigned int create()
+	{
+		unsigned int index;
+		if (!free_indices.empty())
+		{
+			index = free_indices.front();
+			free_indices.pop_front();
+		}
+		else
+		{
+			index = (unsigned int)generations.size();
+			assert(index <= index_mask && "Too many entities alive");
+			generations.push_back(0);
+		}
+		return (generations[index] << index_bits) | index;
+	}
+
+	bool is_alive(unsigned int id) const
+	{
+		unsigned int index = index_of(id);
+		return index != 0 && index < generations.size() && generations[index] == generation_of(id);
+	}
+
+	// Invalidates all handles to 'id' and puts its slot on the free list, destroying twice is a no-op
+	void destroy(unsigned int id)
+	{
+		if (!is_alive(id))
+			return;
+		unsigned int index = index_of(id);
+		generations[index] = (generations[index] + 1) & generation_mask;
+		free_indices.push_back(index);
+	}
+
+	// Number of slots ever used, the upper bound for arrays indexed by entity index
+	size_t capacity() const { return generations.size(); }
+	size_t alive() const { return generations.size() - 1 - free_indices.size(); }
+};
+
+// Unique identifyer for all entities of one registry, new entities come from BasicRegistry::create()
 class Entity
 {
 	unsigned int id;
-	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
 public:
-	Entity()
+	// A default constructed entity is the null entity, it is never alive and no container has it
+	Entity() : id(0) {}
+	// An id handed out by an EntityManager
+	explicit Entity(unsigned int id) : id(id) {}
+	static Entity null()
+	{
+		return Entity();
+	}
+	operator unsigned int() const { return id; } // this enables automatic casting to int
+	unsigned int index() const { return EntityManager::index_of(id); }
+	unsigned int generation() const { return EntityManager::generation_of(id); }
+};
+
+// One bit per component type, set for every component an entity has
+typedef uint64_t ComponentMask;
+
+// The component signature of every entity, indexed by Entity::index().
+// Each slot remembers the full id it belongs to, a recycled index starts over with an empty signature.
+class SignatureTable
+{
+	struct Slot
+	{
+		Entity entity = Entity::null();
+		ComponentMask mask = 0;
+	};
+	std::vector<Slot> slots;
+public:
+	ComponentMask get(Entity e) const
+	{
+		unsigned int index = e.index();
+		return (index < slots.size() && slots[index].entity == e) ? slots[index].mask : 0;
+	}
+
+	// Calls f(Entity) for every entity that has at least one component
+	template <typename Func>
+	void each(Func f) const
+	{
+		for (const Slot& slot : slots)
+			if (slot.mask)
+				f(slot.entity);
+	}
+
+	void set(Entity e, ComponentMask bits)
+	{
+		unsigned int index = e.index();
+		if (index >= slots.size())
+			slots.resize(index + 1);
+		if (slots[index].entity != e)
+		{
+			slots[index].entity = e;
+			slots[index].mask = 0;
+		}
+		slots[index].mask |= bits;
+	}
+
+	void reset(Entity e, ComponentMask bits)
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		unsigned int index = e.index();
+		if (index < slots.size() && slots[index].entity == e)
+			slots[index].mask &= ~bits;
 	}
-	operator unsigned int() { return id; } // this enables automatic casting to int
 };
 
-// Common interface to refer to all containers in the ECS registry
-struct ContainerInterface
+// Maps an entity index to a position in a dense array (a "sparse set" index).
+// The ids are split in fixed size pages that are only allocated once an id in that range is used,
+// so a lookup is two array reads instead of a hash probe and memory stays proportional to the used id ranges.
+class SparseIndex
 {
-	virtual void clear() = 0;
-	virtual size_t size() = 0;
-	virtual void remove(Entity e) = 0;
-	virtual bool has(Entity entity) = 0;
+	static const unsigned int page_bits = 12;
+	static const unsigned int page_size = 1u << page_bits; // 4096 ids per page
+	std::vector<std::unique_ptr<unsigned int[]>> pages;
+public:
+	static const unsigned int null_index = ~0u;
+
+	// Returns the dense position of 'id' or null_index if the id is not contained
+	unsigned int find(unsigned int id) const
+	{
+		unsigned int page = id >> page_bits;
+		if (page >= pages.size() || !pages[page])
+			return null_index;
+		return pages[page][id & (page_size - 1)];
+	}
+
+	// Returns the slot of 'id', allocating its page on first use
+	unsigned int& operator[](unsigned int id)
+	{
+		unsigned int page = id >> page_bits;
+		if (page >= pages.size())
+			pages.resize(page + 1);
+		if (!pages[page])
+		{
+			pages[page].reset(new unsigned int[page_size]);
+			std::fill(pages[page].get(), pages[page].get() + page_size, (unsigned int)null_index);
+		}
+		return pages[page][id & (page_size - 1)];
+	}
+
+	// Memory of the allocated pages and the page table
+	size_t bytes() const
+	{
+		size_t used = pages.capacity() * sizeof(pages[0]);
+		for (const auto& page : pages)
+			if (page)
+				used += page_size * sizeof(unsigned int);
+		return used;
+	}
+
+	void erase(unsigned int id)
+	{
+		unsigned int page = id >> page_bits;
+		if (page < pages.size() && pages[page])
+			pages[page][id & (page_size - 1)] = null_index;
+	}
 };
 
+// Storage for tag components (empty structs like Player or Obstacle), there is nothing to store per entity.
+// Instead it keeps one bit per entity index, so that has() on an entity without the tag is a single bit test.
+template <typename Component>
+class TagStorage
+{
+	size_t count = 0;
+	std::vector<uint64_t> bits;
+public:
+	typedef Component value_type;
+	typedef Component& reference;
+	typedef Component* pointer;
+
+	// All elements are the same empty object
+	Component& operator[](size_t) { static Component instance; return instance; }
+	Component& back() { return (*this)[0]; }
+	pointer address(size_t i) { return &(*this)[i]; }
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	// The entity indices the bits cover
+	size_t capacity() const { return bits.size() * 64; }
+	size_t bytes() const { return bits.capacity() * sizeof(uint64_t); }
+	void push_back(const Component&) { count++; }
+	void pop_back() { count--; }
+	void reserve(size_t) {}
+	void clear()
+	{
+		count = 0;
+		std::fill(bits.begin(), bits.end(), (uint64_t)0);
+	}
+
+	bool test(unsigned int index) const
+	{
+		return (index >> 6) < bits.size() && ((bits[index >> 6] >> (index & 63)) & 1);
+	}
+	void set(unsigned int index)
+	{
+		if ((index >> 6) >= bits.size())
+			bits.resize((index >> 6) + 1, 0);
+		bits[index >> 6] |= (uint64_t)1 << (index & 63);
+	}
+	void reset(unsigned int index)
+	{
+		if ((index >> 6) < bits.size())
+			bits[index >> 6] &= ~((uint64_t)1 << (index & 63));
+	}
+};
+
+// Storage that keeps the components in fixed-size pages. Growing adds a page and never moves the components already stored,
+// so references from get() stay valid while other components are inserted and there is no reallocation copy mid-frame.
+// remove() still moves the last component into the hole, and the pages stay allocated until the storage is destroyed.
+// A container owned by a BasicOwningGroup loses the guarantee, the group swaps components around on every insert.
+template <typename Component, size_t PageSize = 256>
+class PagedStorage
+{
+	static_assert((PageSize & (PageSize - 1)) == 0, "The page size must be a power of two");
+
+	typedef typename std::aligned_storage<sizeof(Component), alignof(Component)>::type Slot;
+	std::vector<std::unique_ptr<Slot[]>> pages;
+	size_t count = 0;
+
+public:
+	typedef Component value_type;
+	typedef Component& reference;
+	typedef Component* pointer;
+
+	class iterator
+	{
+		PagedStorage* storage;
+		size_t i;
+	public:
+		iterator(PagedStorage* storage, size_t i) : storage(storage), i(i) {}
+		Component& operator*() const { return (*storage)[i]; }
+		iterator& operator++() { i++; return *this; }
+		bool operator==(const iterator& other) const { return i == other.i; }
+		bool operator!=(const iterator& other) const { return i != other.i; }
+	};
+
+	PagedStorage() {}
+	~PagedStorage() { clear(); }
+
+	PagedStorage(PagedStorage&& other) : pages(std::move(other.pages)), count(other.count) { other.count = 0; }
+	PagedStorage& operator=(PagedStorage&& other)
+	{
+		clear();
+		pages = std::move(other.pages);
+		count = other.count;
+		other.count = 0;
+		return *this;
+	}
+	PagedStorage(const PagedStorage&) = delete;
+	PagedStorage& operator=(const PagedStorage&) = delete;
+
+	Component& operator[](size_t i) { return *std::launder(reinterpret_cast<Component*>(&pages[i / PageSize][i % PageSize])); }
+	Component& back() { return (*this)[count - 1]; }
+	pointer address(size_t i) { return &(*this)[i]; }
+
+	// How many elements from 'first' on are contiguous in memory, up to the end of its page
+	size_t contiguous_from(size_t first) const { return std::min(count - first, PageSize - first % PageSize); }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, count); }
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	size_t capacity() const { return pages.size() * PageSize; }
+	size_t bytes() const { return capacity() * sizeof(Slot) + pages.capacity() * sizeof(pages[0]); }
+
+	void push_back(Component c)
+	{
+		reserve(count + 1);
+		new (&pages[count / PageSize][count % PageSize]) Component(std::move(c));
+		count++;
+	}
+
+	void pop_back()
+	{
+		(*this)[--count].~Component();
+	}
+
+	void clear()
+	{
+		while (count > 0)
+			pop_back();
+	}
+
+	void reserve(size_t n)
+	{
+		while (pages.size() * PageSize < n)
+			pages.emplace_back(new Slot[PageSize]);
+	}
+};
+
+template <typename Component>
+class SharedStorage;
+
+// Reference to one element of a SharedStorage. Reads give the shared value, assigning a value makes the element
+// share (or add) that value instead of writing into the one other elements use. Copy it into a Component to modify fields.
+template <typename Component>
+class SharedRef
+{
+	SharedStorage<Component>* storage;
+	size_t i;
+public:
+	SharedRef(SharedStorage<Component>* storage, size_t i) : storage(storage), i(i) {}
+	SharedRef(const SharedRef& other) = default;
+
+	operator const Component&() const { return storage->value(i); }
+	const Component* operator->() const { return &storage->value(i); }
+
+	// Elements with the same value index hold equal components
+	uint32_t value_index() const { return storage->value_index(i); }
+
+	SharedRef& operator=(const Component& c) { storage->set(i, c); return *this; }
+	SharedRef& operator=(const SharedRef& other)
+	{
+		if (other.storage == storage)
+			storage->share(i, other.i);
+		else
+			storage->set(i, other);
+		return *this;
+	}
+
+	// Exchanges the values of two elements, for ComponentContainer::swap_elements
+	friend void swap(SharedRef a, SharedRef b)
+	{
+		if (a.storage == b.storage)
+			a.storage->swap(a.i, b.i);
+		else
+		{
+			Component tmp = a;
+			a = b;
+			b = tmp;
+		}
+	}
+};
+
+// Storage for components that many entities have the same value of, e.g. every rock's RenderRequest.
+// Each distinct value is stored once and every element keeps the 4 byte index of its value, so code can group elements
+// by value_index() instead of comparing the components. Values are compared bytewise and there are few of them, so the
+// lookup is a linear scan. A value whose last element is gone or changed is recycled.
+template <typename Component>
+class SharedStorage
+{
+	static_assert(std::is_trivially_copyable<Component>::value, "Shared components are compared bytewise");
+
+	std::vector<Component> values;
+	std::vector<uint32_t> use_counts;
+	std::vector<uint32_t> free_values;
+	// The value of every element
+	std::vector<uint32_t> indices;
+
+	uint32_t acquire(const Component& c)
+	{
+		for (uint32_t v = 0; v < values.size(); v++)
+			if (use_counts[v] > 0 && memcmp(&values[v], &c, sizeof(Component)) == 0)
+			{
+				use_counts[v]++;
+				return v;
+			}
+		uint32_t v;
+		if (!free_values.empty())
+		{
+			v = free_values.back();
+			free_values.pop_back();
+			values[v] = c;
+		}
+		else
+		{
+			v = (uint32_t)values.size();
+			values.push_back(c);
+			use_counts.push_back(0);
+		}
+		use_counts[v] = 1;
+		return v;
+	}
+
+	void release(uint32_t v)
+	{
+		if (--use_counts[v] == 0)
+			free_values.push_back(v);
+	}
+
+public:
+	typedef Component value_type;
+	typedef SharedRef<Component> reference;
+	// try_get() points at the shared value, it is read-only
+	typedef const Component* pointer;
+
+	size_t size() const { return indices.size(); }
+	bool empty() const { return indices.empty(); }
+	size_t capacity() const { return indices.capacity(); }
+	size_t bytes() const
+	{
+		return values.capacity() * sizeof(Component) + (use_counts.capacity() + free_values.capacity() + indices.capacity()) * sizeof(uint32_t);
+	}
+	// The number of different values in use
+	size_t distinct_values() const { return values.size() - free_values.size(); }
+
+	reference operator[](size_t i) { return reference(this, i); }
+	reference back() { return (*this)[indices.size() - 1]; }
+	pointer address(size_t i) { return &values[indices[i]]; }
+
+	const Component& value(size_t i) const { return values[indices[i]]; }
+	uint32_t value_index(size_t i) const { return indices[i]; }
+
+	void push_back(const Component& c) { indices.push_back(acquire(c)); }
+	void pop_back()
+	{
+		release(indices.back());
+		indices.pop_back();
+	}
+	void clear()
+	{
+		values.clear();
+		use_counts.clear();
+		free_values.clear();
+		indices.clear();
+	}
+	void reserve(size_t n) { indices.reserve(n); }
+
+	// Gives element i the value c. The new value is acquired first, so setting the current value keeps it.
+	void set(size_t i, const Component& c)
+	{
+		uint32_t v = acquire(c);
+		release(indices[i]);
+		indices[i] = v;
+	}
+	// Gives element i the value of element 'from' without comparing
+	void share(size_t i, size_t from)
+	{
+		use_counts[indices[from]]++;
+		release(indices[i]);
+		indices[i] = indices[from];
+	}
+	void swap(size_t i, size_t j) { std::swap(indices[i], indices[j]); }
+};
+
+// The storage ComponentContainer<Component> keeps its components in, specialize it to change the layout of a component type (e.g. motion_soa.hpp).
+// A storage offers the std::vector members the container uses (push_back, pop_back, back, operator[], clear, size, reserve).
+// Empty components are tags and go to TagStorage, the others to PagedStorage so that references survive inserts.
+// Components with few distinct values can be specialized to SharedStorage, see tiny_ecs_registry.hpp.
+template <typename Component>
+struct component_storage
+{
+	typedef typename std::conditional<std::is_empty<Component>::value, TagStorage<Component>, PagedStorage<Component>>::type type;
+};
+
+// What get() and try_get() return for a storage, a storage can hand out proxies instead of plain references.
+// may_contain() is a quick test that lets has() reject an entity before the sparse lookup, on_insert/on_remove keep it up to date.
+// capacity() and bytes() are reported by ComponentContainer::stats().
+template <class Storage>
+struct storage_traits
+{
+	typedef typename Storage::reference reference;
+	typedef typename Storage::pointer pointer;
+	static size_t capacity(const Storage& storage) { return storage.capacity(); }
+	static size_t bytes(const Storage& storage) { return storage.bytes(); }
+	static pointer address(Storage& storage, size_t i) { return storage.address(i); }
+	static bool may_contain(const Storage&, Entity) { return true; }
+	static void on_insert(Storage&, Entity) {}
+	static void on_remove(Storage&, Entity) {}
+};
+
+template <typename Component>
+struct storage_traits<std::vector<Component>>
+{
+	typedef Component& reference;
+	typedef Component* pointer;
+	static size_t capacity(const std::vector<Component>& storage) { return storage.capacity(); }
+	static size_t bytes(const std::vector<Component>& storage) { return storage.capacity() * sizeof(Component); }
+	static pointer address(std::vector<Component>& storage, size_t i) { return &storage[i]; }
+	static bool may_contain(const std::vector<Component>&, Entity) { return true; }
+	static void on_insert(std::vector<Component>&, Entity) {}
+	static void on_remove(std::vector<Component>&, Entity) {}
+};
+
+template <typename Component>
+struct storage_traits<TagStorage<Component>>
+{
+	typedef Component& reference;
+	typedef Component* pointer;
+	static size_t capacity(const TagStorage<Component>& storage) { return storage.capacity(); }
+	static size_t bytes(const TagStorage<Component>& storage) { return storage.bytes(); }
+	static pointer address(TagStorage<Component>& storage, size_t i) { return storage.address(i); }
+	static bool may_contain(const TagStorage<Component>& storage, Entity e) { return storage.test(e.index()); }
+	static void on_insert(TagStorage<Component>& storage, Entity e) { storage.set(e.index()); }
+	static void on_remove(TagStorage<Component>& storage, Entity e) { storage.reset(e.index()); }
+};
+
+// In-place heap sort of the positions [0, n), for data that lives in several arrays which std::sort can't permute together.
+// less(i, j) compares the elements at two positions and swap(i, j) exchanges them, nothing is allocated.
+template <class Less, class Swap>
+void heap_sort(size_t n, Less less, Swap swap)
+{
+	auto sift_down = [&](size_t root, size_t end) {
+		while (2 * root + 1 < end)
+		{
+			size_t child = 2 * root + 1;
+			if (child + 1 < end && less(child, child + 1))
+				child++;
+			if (!less(root, child))
+				return;
+			swap(root, child);
+			root = child;
+		}
+	};
+	for (size_t start = n / 2; start-- > 0;)
+		sift_down(start, n);
+	for (size_t end = n; end-- > 1;)
+	{
+		swap(0, end);
+		sift_down(0, end);
+	}
+}
+
+// Listeners that are called with an entity, see ComponentContainer::on_construct and on_destroy.
+// Listeners must not connect or disconnect while the signal is emitting.
+class Signal
+{
+	std::vector<std::pair<unsigned int, std::function<void(Entity)>>> listeners;
+	unsigned int next_id = 0;
+public:
+	// Returns the id to disconnect the listener with
+	unsigned int connect(std::function<void(Entity)> listener)
+	{
+		listeners.emplace_back(++next_id, std::move(listener));
+		return next_id;
+	}
+
+	void disconnect(unsigned int id)
+	{
+		listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [id](const auto& l) { return l.first == id; }), listeners.end());
+	}
+
+	bool empty() const { return listeners.empty(); }
+
+	void emit(Entity e)
+	{
+		for (auto& listener : listeners)
+			listener.second(e);
+	}
+};
+
+// Disconnects a listener when it goes out of scope. Objects that connect listeners capturing 'this' keep these,
+// so that the registry doesn't call into them after they are gone, e.g. Connection(c.on_destroy, c.on_destroy.connect(f)).
+class Connection
+{
+	Signal* signal = nullptr;
+	unsigned int id = 0;
+public:
+	Connection() {}
+	Connection(Signal& signal, unsigned int id) : signal(&signal), id(id) {}
+	~Connection() { disconnect(); }
+
+	// Only one of the copies could disconnect
+	Connection(const Connection&) = delete;
+	Connection& operator=(const Connection&) = delete;
+	Connection(Connection&& other) noexcept : signal(other.signal), id(other.id) { other.signal = nullptr; }
+	Connection& operator=(Connection&& other) noexcept
+	{
+		if (this != &other)
+		{
+			disconnect();
+			signal = other.signal;
+			id = other.id;
+			other.signal = nullptr;
+		}
+		return *this;
+	}
+
+	void disconnect()
+	{
+		if (signal)
+			signal->disconnect(id);
+		signal = nullptr;
+	}
+};
+
+// Occupancy and memory of one container, see ComponentContainer::stats() and BasicRegistry::stats()
+struct ContainerStats
+{
+	std::string name;
+	size_t size = 0;
+	size_t capacity = 0;
+	// The largest size since the container was created
+	size_t peak_size = 0;
+	// Bytes allocated for the components, for the entity and change tick arrays and for the sparse index
+	size_t component_bytes = 0;
+	size_t entity_bytes = 0;
+	size_t index_bytes = 0;
+	// Components inserted and removed during the last completed frame, see BasicRegistry::advance_tick()
+	size_t inserts = 0;
+	size_t removes = 0;
+};
+
+// The stats of a plain vector kept next to the containers, e.g. the sprite lists of ECSRegistry
+template <typename T>
+ContainerStats vector_stats(const char* name, const std::vector<T>& v)
+{
+	ContainerStats stats;
+	stats.name = name;
+	stats.size = stats.peak_size = v.size();
+	stats.capacity = v.capacity();
+	stats.component_bytes = v.capacity() * sizeof(T);
+	return stats;
+}
+
+// A readable name of a type for debug output, "Motion" instead of the mangled typeid name, see tiny_ecs.cpp
+std::string type_name(const std::type_info& type);
+
+// Appends one CSV row per container to the file at 'path', starting with the header when the file is new.
+// The tick is the first column so that dumps of several frames can share a file. Returns false if it can't be written.
+bool write_stats_csv(const std::vector<ContainerStats>& stats, uint32_t tick, const char* path);
+
 // A container that stores components of type 'Component' and associated entities
-template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+template <typename Component, class Storage = typename component_storage<Component>::type> // A component can be any class
+class ComponentContainer
 {
+public:
+	typedef typename storage_traits<Storage>::reference reference;
+	typedef typename storage_traits<Storage>::pointer pointer;
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
+	// The sparse index from Entity::index() -> array index, the stored entity tells the generation apart.
+	SparseIndex map_entity_componentID;
 	bool registered = false;
 public:
 	// Container of all components of type 'Component'
-	std::vector<Component> components;
+	Storage components;
 
 	// The corresponding entities
 	std::vector<Entity> entities;
 
+	// Assigned by the registry, the container keeps its bit up to date in the signature of its entities
+	SignatureTable* signatures = nullptr;
+	ComponentMask signature_bit = 0;
+
+	// Change tracking, the registry tick at which each component was inserted or last touched, parallel to entities.
+	// Writes through get() are not seen, use patch() or touch() for changes other systems should notice.
+	std::vector<uint32_t> changed_ticks;
+	// The tick of the last insert, touch or remove in the container
+	uint32_t last_changed_tick = 0;
+	// Assigned by the registry, see BasicRegistry::advance_tick()
+	const uint32_t* tick = nullptr;
+
+	// Emitted after a component was inserted and before one is removed, with the component still in place.
+	// Subsystems keep their indexes (counts, singleton handles, groups) up to date with them instead of rescanning.
+	Signal on_construct;
+	Signal on_destroy;
+
+	// Set by the OwningGroup that owns this container, the group decides the order of the components.
+	// References from get() then only last until the next insert or remove, see BasicOwningGroup.
+	bool owned_by_group = false;
+
+private:
+	// The capacity of the last reserve(), growing past it is reported once. A container without a reserve() yet
+	// isn't checked, after the first one a capacity of 0 (a type the profile left out) is reported like any other.
+	size_t reserved = 0;
+	bool capacity_checked = false;
+	bool overflow_reported = false;
+
+	// For stats(), the counts of the current frame move to the last frame ones in end_frame()
+	size_t peak_size = 0;
+	size_t frame_inserts = 0;
+	size_t frame_removes = 0;
+	size_t last_frame_inserts = 0;
+	size_t last_frame_removes = 0;
+public:
+
 	// Constructor that registers the type
 	ComponentContainer()
 	{
 	}
 
 	// Inserting a component c associated to entity e
-	inline Component& insert(Entity e, Component c, bool check_for_duplicates = true)
+	inline reference insert(Entity e, Component c, bool check_for_duplicates = true)
 	{
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
+		assert(e != Entity::null() && "Create entities with registry.create()");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		map_entity_componentID[e.index()] = (unsigned int)components.size();
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
+		changed_ticks.push_back(last_changed_tick = current_tick());
+		frame_inserts++;
+		peak_size = std::max(peak_size, entities.size());
+		if (capacity_checked && !overflow_reported && entities.size() > reserved)
+		{
+			overflow_reported = true;
+			printf("Container of %s grew past its reserved capacity of %d\n", type_name(typeid(Component)).c_str(), (int)reserved);
+		}
+		storage_traits<Storage>::on_insert(components, e);
+		if (signatures)
+			signatures->set(e, signature_bit);
+		if (!on_construct.empty())
+		{
+			// a group may have moved the new component away from the back
+			on_construct.emit(e);
+			return components[map_entity_componentID.find(e.index())];
+		}
 		return components.back();
 	};
 
 	// The emplace function takes the the provided arguments Args, creates a new object of type Component, and inserts it into the ECS system
 	template<typename... Args>
-	Component& emplace(Entity e, Args &&... args) {
+	reference emplace(Entity e, Args &&... args) {
 		return insert(e, Component(std::forward<Args>(args)...));
 	};
 	template<typename... Args>
-	Component& emplace_with_duplicates(Entity e, Args &&... args) {
+	reference emplace_with_duplicates(Entity e, Args &&... args) {
 		return insert(e, Component(std::forward<Args>(args)...), false);
 	};
 
 	// A wrapper to return the component of an entity
-	Component& get(Entity e) {
+	reference get(Entity e) {
 		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		return components[map_entity_componentID.find(e.index())];
+	}
+
+	// get() for writing, the component counts as changed in the current tick
+	reference patch(Entity e) {
+		touch(e);
+		return get(e);
+	}
+
+	// Marks the component of 'e' as changed in the current tick
+	void touch(Entity e) {
+		changed_ticks[index_of(e)] = last_changed_tick = current_tick();
+	}
+
+	// Whether the component of 'e' was inserted or touched at or after 'since'
+	bool changed_since(Entity e, uint32_t since) {
+		return changed_ticks[index_of(e)] >= since;
+	}
+
+	// Whether anything in the container was inserted, touched or removed at or after 'since'
+	bool changed_since(uint32_t since) const {
+		return last_changed_tick >= since;
+	}
+
+	// Calls f(Entity, reference) for the components inserted or touched at or after 'since'
+	template <typename Func>
+	void each_changed_since(uint32_t since, Func f) {
+		for (size_t i = 0; i < entities.size(); i++)
+			if (changed_ticks[i] >= since)
+				f(entities[i], components[i]);
+	}
+
+	uint32_t current_tick() const {
+		return tick ? *tick : 0;
 	}
 
 	// Check if entity has a component of type 'Component'
 	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+		if (!storage_traits<Storage>::may_contain(components, entity))
+			return false;
+		// A stale handle maps to the same slot as the entity that reused its index, compare the full id
+		unsigned int cID = map_entity_componentID.find(entity.index());
+		return cID != SparseIndex::null_index && entities[cID] == entity;
+	}
+
+	// Returns the component of 'e' or nullptr, a single lookup where has() followed by get() takes two
+	pointer try_get(Entity e) {
+		unsigned int cID = map_entity_componentID.find(e.index());
+		return (cID != SparseIndex::null_index && entities[cID] == e) ? storage_traits<Storage>::address(components, cID) : pointer();
+	}
+
+	// The position of the component of 'e' in components and entities
+	unsigned int index_of(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		return map_entity_componentID.find(e.index());
 	}
 
 	// Remove an component and pack the container to re-use the empty space
@@ -89,29 +815,87 @@ public:
 	{
 		if (has(e))
 		{
+			on_destroy.emit(e);
+
 			// Get the current position
-			int cID = map_entity_componentID[e];
+			int cID = map_entity_componentID[e.index()];
 
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			changed_ticks[cID] = changed_ticks.back();
+			map_entity_componentID[entities.back().index()] = cID;
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			map_entity_componentID.erase(e.index());
 			components.pop_back();
 			entities.pop_back();
-			// Note, one could mark the id for re-use
+			changed_ticks.pop_back();
+			frame_removes++;
+			last_changed_tick = current_tick();
+			storage_traits<Storage>::on_remove(components, e);
+			if (signatures)
+				signatures->reset(e, signature_bit);
 		}
 	};
 
+	// Removes the components of all entities for which doomed(e) holds, in one pass that packs the remaining
+	// components in their current order. Doesn't emit on_destroy, see BasicRegistry::destroy() which does.
+	template <typename Predicate>
+	void remove_if(Predicate doomed)
+	{
+		size_t kept = 0;
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			Entity e = entities[i];
+			if (doomed(e))
+			{
+				map_entity_componentID.erase(e.index());
+				storage_traits<Storage>::on_remove(components, e);
+				if (signatures)
+					signatures->reset(e, signature_bit);
+				continue;
+			}
+			if (kept != i)
+			{
+				components[kept] = std::move(components[i]);
+				entities[kept] = e;
+				changed_ticks[kept] = changed_ticks[i];
+				map_entity_componentID[e.index()] = (unsigned int)kept;
+			}
+			kept++;
+		}
+		if (kept == entities.size())
+			return;
+		frame_removes += entities.size() - kept;
+		while (components.size() > kept)
+			components.pop_back();
+		entities.resize(kept);
+		changed_ticks.resize(kept);
+		last_changed_tick = current_tick();
+	}
+
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		// The listeners see every component go, one by one
+		if (!on_destroy.empty())
+			while (!entities.empty())
+				remove(entities.back());
+
+		// Only reset the slots in use, the pages stay allocated for the next round of entities
+		frame_removes += entities.size();
+		for (Entity e : entities)
+		{
+			map_entity_componentID.erase(e.index());
+			if (signatures)
+				signatures->reset(e, signature_bit);
+		}
 		components.clear();
 		entities.clear();
+		changed_ticks.clear();
+		last_changed_tick = current_tick();
 	}
 
 	// Report the number of components of type 'Component'
@@ -120,18 +904,859 @@ public:
 		return components.size();
 	}
 
-	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	// Size, capacity, memory and churn of the container
+	ContainerStats stats()
+	{
+		ContainerStats stats;
+		stats.name = type_name(typeid(Component));
+		stats.size = entities.size();
+		stats.capacity = storage_traits<Storage>::capacity(components);
+		stats.peak_size = peak_size;
+		stats.component_bytes = storage_traits<Storage>::bytes(components);
+		stats.entity_bytes = entities.capacity() * sizeof(Entity) + changed_ticks.capacity() * sizeof(uint32_t);
+		stats.index_bytes = map_entity_componentID.bytes();
+		stats.inserts = last_frame_inserts;
+		stats.removes = last_frame_removes;
+		return stats;
+	}
+
+	// Closes the frame for the insert and remove counts of stats()
+	void end_frame()
+	{
+		last_frame_inserts = frame_inserts;
+		last_frame_removes = frame_removes;
+		frame_inserts = frame_removes = 0;
+	}
+
+	// Makes room for n components so that inserting up to n doesn't allocate, see BasicRegistry::reserve()
+	void reserve(size_t n)
+	{
+		components.reserve(n);
+		entities.reserve(n);
+		changed_ticks.reserve(n);
+		reserved = n;
+		capacity_checked = true;
+		overflow_reported = false;
+	}
+
+	// Makes room for n more components at once, see BasicRegistry::spawn_batch(). Grows geometrically like push_back
+	// would and leaves the capacity of reserve() that overflows are reported against as it is.
+	void reserve_more(size_t n)
+	{
+		size_t needed = entities.size() + n;
+		if (needed <= entities.capacity())
+			return;
+		needed = std::max(needed, 2 * entities.size());
+		components.reserve(needed);
+		entities.reserve(needed);
+		changed_ticks.reserve(needed);
+	}
+
+	// Exchange the components and entities at two positions, the index follows so lookups stay valid
+	void swap_elements(size_t i, size_t j)
+	{
+		if (i == j)
+			return;
+		using std::swap;
+		swap(components[i], components[j]);
+		std::swap(entities[i], entities[j]);
+		std::swap(changed_ticks[i], changed_ticks[j]);
+		map_entity_componentID[entities[i].index()] = (unsigned int)i;
+		map_entity_componentID[entities[j].index()] = (unsigned int)j;
+	}
+
+	// Calls f(Entity, reference) for every component like a loop over entities and components, split into chunks of 'grain'
+	// components that run on the pool. f may write the component it is given and read other containers, it must not add
+	// or remove components, write other entities, or patch() (the change ticks are shared).
+	template <typename Func>
+	void parallel_for_each(ThreadPool& pool, Func f, size_t grain = ThreadPool::default_grain)
+	{
+		static_assert(!std::is_same<reference, SharedRef<Component>>::value, "Writing a shared component can add a value, which isn't thread safe");
+		pool.parallel_for(entities.size(), grain, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				f(entities[i], components[i]);
+		});
+	}
+
+	// Sort the components and associated entity assignment structures by the comparisonFunction(Entity, Entity), see std::sort.
+	// Sorts in place with swap_elements, so nothing is allocated and get() stays valid inside comparisonFunction.
+	// Not for containers with duplicates or owned by a group (sort the group instead).
 	template <class Compare>
 	void sort(Compare comparisonFunction)
 	{
-		// First sort the entity list as desired
-		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
-		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+		assert(!owned_by_group && "Container is owned by a group, sort the group");
+		heap_sort(entities.size(),
+			[&](size_t i, size_t j) { return comparisonFunction(entities[i], entities[j]); },
+			[&](size_t i, size_t j) { swap_elements(i, j); });
+	}
+};
+
+// A list of component types, names the included and excluded components of a View
+template <typename... Components>
+struct type_list {};
+
+// Whether T is one of Ts...
+template <typename T, typename... Ts>
+struct is_one_of : std::integral_constant<bool, (std::is_same<T, Ts>::value || ...)> {};
+
+// Iterates all entities that have every 'Include' component and none of the 'Exclude' components, e.g.
+//   registry.view<Motion, Deadly>().exclude<DeathTimer>().each([](Entity e, MotionRef motion, Deadly& deadly) { ... });
+// The loop is driven by the smallest included container, so every entity costs one lookup per other component
+// instead of a has() and get() per component. 'Registry' is anything with a get<Component>() returning the ComponentContainer.
+template <class Registry, class Include, class Exclude = type_list<>>
+class View;
+
+template <class Registry, typename... Include, typename... Exclude>
+class View<Registry, type_list<Include...>, type_list<Exclude...>>
+{
+	template <class, class, class> friend class View;
+
+	Registry* registry;
+	std::tuple<ComponentContainer<Include>*...> included;
+	std::tuple<ComponentContainer<Exclude>*...> excluded;
+	std::vector<Entity>* driver;
+
+	// 'e' is unused when there is nothing to exclude
+	bool is_excluded([[maybe_unused]] Entity e) const
+	{
+		return (std::get<ComponentContainer<Exclude>*>(excluded)->has(e) || ...);
+	}
+
+	template <typename Func>
+	static void call(Func& f, Entity e, typename ComponentContainer<Include>::pointer... components)
+	{
+		bool all = true;
+		using expand = int[];
+		(void)expand{ 0, (all = all && bool(components), 0)... };
+		if (all)
+			f(e, *components...);
+	}
+
+	// How parallel_each passes a component, a reference if it is written and a const one (for a Motion a copy) otherwise
+	template <typename Component, typename... Written>
+	using access = typename std::conditional<is_one_of<Component, Written...>::value,
+		typename ComponentContainer<Component>::reference, const Component&>::type;
+
+	template <typename... Written, typename Func>
+	static void call_with_access(type_list<Written...>, Func& f, Entity e, typename ComponentContainer<Include>::pointer... components)
+	{
+		bool all = true;
+		using expand = int[];
+		(void)expand{ 0, (all = all && bool(components), 0)... };
+		if (all)
+			f(e, static_cast<access<Include, Written...>>(*components)...);
+	}
+
+public:
+	View(Registry& registry)
+		: registry(&registry)
+		, included(&registry.template get<Include>()...)
+		, excluded(&registry.template get<Exclude>()...)
+	{
+		// Drive off the smallest container, the first listed one on ties
+		std::vector<Entity>* candidates[] = { &std::get<ComponentContainer<Include>*>(included)->entities... };
+		driver = candidates[0];
+		for (std::vector<Entity>* candidate : candidates)
+			if (candidate->size() < driver->size())
+				driver = candidate;
+	}
+
+	// Additionally skip entities that have any of the 'More' components
+	template <typename... More>
+	View<Registry, type_list<Include...>, type_list<Exclude..., More...>> exclude() const
+	{
+		View<Registry, type_list<Include...>, type_list<Exclude..., More...>> view(*registry);
+		view.driver = driver;
+		return view;
+	}
+
+	// Drive the loop by the container of 'Component' instead of the smallest one, for loops that depend on its order (e.g. the draw order of renderRequests)
+	template <typename Component>
+	View use() const
+	{
+		View view = *this;
+		view.driver = &std::get<ComponentContainer<Component>*>(included)->entities;
+		return view;
+	}
+
+	// Calls f(Entity, Include&...) for every matching entity, a component with its own storage is passed as its reference type (e.g. MotionRef).
+	// Entities created during the loop are visited as well, but don't remove the viewed components inside f.
+	template <typename Func>
+	void each(Func f)
+	{
+		for (size_t i = 0; i < driver->size(); i++)
+		{
+			Entity e = (*driver)[i];
+			if (is_excluded(e))
+				continue;
+			call(f, e, std::get<ComponentContainer<Include>*>(included)->try_get(e)...);
+		}
+	}
+
+	// each() split into chunks of 'grain' entities that run on the pool, e.g.
+	//   registry.view<Motion, Grenade>().parallel_each<Motion>(pool, [](Entity e, MotionRef motion, const Grenade& grenade) { ... });
+	// Only the 'Written' components are passed as writable references, the others as const, so a loop can't write a
+	// component it didn't declare. f must not add or remove components or write other entities.
+	template <typename... Written, typename Func>
+	void parallel_each(ThreadPool& pool, Func f, size_t grain = ThreadPool::default_grain)
+	{
+		static_assert((is_one_of<Written, Include...>::value && ...), "Only included components can be written");
+		static_assert((!std::is_same<typename ComponentContainer<Written>::reference, SharedRef<Written>>::value && ...),
+			"Writing a shared component can add a value, which isn't thread safe");
+		pool.parallel_for(driver->size(), grain, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				Entity e = (*driver)[i];
+				if (is_excluded(e))
+					continue;
+				call_with_access(type_list<Written...>(), f, e, std::get<ComponentContainer<Include>*>(included)->try_get(e)...);
+			}
+		});
+	}
+};
+
+// Records structural changes (create, emplace, remove, destroy) while a system iterates the containers and applies
+// them in one batch at flush(). Removing from a container swaps its last element into the hole, so doing it
+// in the middle of a loop over that container skips or revisits entities. 'Registry' is anything with
+// get<Component>() and destroy(const std::vector<Entity>&), see ECSRegistry.
+template <class Registry>
+class CommandBuffer
+{
+	Registry* registry;
+	std::vector<std::function<void(Registry&)>> commands;
+
+	// The entities queued for destruction, destroy_marks holds the full id at their index
+	std::vector<Entity> pending_destroy;
+	std::vector<unsigned int> destroy_marks;
+
+public:
+	CommandBuffer(Registry& registry) : registry(&registry) {}
+
+	// The id is handed out right away so that components can be queued for it, they are attached at flush()
+	Entity create()
+	{
+		return registry->create();
+	}
+
+	template <typename Component, typename... Args>
+	void emplace(Entity e, Args &&... args)
+	{
+		Component c(std::forward<Args>(args)...);
+		commands.push_back([e, c](Registry& registry) {
+			if (registry.is_alive(e))
+				registry.template get<Component>().insert(e, c);
+		});
+	}
+
+	template <typename Component>
+	void remove(Entity e)
+	{
+		commands.push_back([e](Registry& registry) {
+			registry.template get<Component>().remove(e);
+		});
+	}
+
+	// Queues the destruction of e, queueing the same entity twice destroys it once
+	void destroy(Entity e)
+	{
+		if (is_pending_destroy(e))
+			return;
+		unsigned int index = e.index();
+		if (index >= destroy_marks.size())
+			destroy_marks.resize(index + 1, 0);
+		destroy_marks[index] = e;
+		pending_destroy.push_back(e);
+	}
+
+	// Lets a loop skip entities that were already handled and are going away at the next flush()
+	bool is_pending_destroy(Entity e) const
+	{
+		unsigned int index = e.index();
+		return index < destroy_marks.size() && destroy_marks[index] == e;
+	}
+
+	// Applies all recorded changes in the order they were recorded, the destroyed entities go last in one batch
+	void flush()
+	{
+		// Index based, a command may record further commands which are applied in the same flush
+		for (size_t i = 0; i < commands.size(); i++)
+		{
+			std::function<void(Registry&)> command = std::move(commands[i]);
+			command(*registry);
+		}
+		registry->destroy(pending_destroy);
+		clear();
+	}
+
+	// Drops all recorded changes without applying them
+	void clear()
+	{
+		commands.clear();
+		for (Entity e : pending_destroy)
+			destroy_marks[e.index()] = 0;
+		pending_destroy.clear();
+	}
+};
+
+// Components the members of a group must have without the group owning their containers, see BasicOwningGroup
+template <typename... Components>
+struct With {};
+
+template <class Registry, class Required, typename... Owned>
+class BasicOwningGroup;
+
+// Keeps the entities that have all of the 'Owned' and 'Required' components at the front of each of the owned containers,
+// in the same order. Loops then walk the dense arrays side by side, e.g. renderRequests.components[i] belongs to
+// entity(i) for i < size(), and look the required components up.
+// The group takes over the order of the containers it owns, a container can only be owned by one group.
+// Owned containers give up the reference stability of their storage: adding or removing a component of any owned type
+// swaps elements to keep the members packed, so a reference from get() may then point at another entity's component.
+// The required containers are only read, keep a container whose references must stay valid there (e.g. the motions).
+template <class Registry, typename... Required, typename... Owned>
+class BasicOwningGroup<Registry, With<Required...>, Owned...>
+{
+	std::tuple<ComponentContainer<Owned>*...> containers;
+	std::tuple<ComponentContainer<Required>*...> required;
+	size_t count = 0;
+	// The listeners of the owned and required containers, disconnected when the group goes
+	std::vector<Connection> connections;
+
+	template <typename Component>
+	ComponentContainer<Component>& container() const
+	{
+		return *std::get<ComponentContainer<Component>*>(containers);
+	}
+
+	template <typename Component>
+	ComponentContainer<Component>& required_container() const
+	{
+		return *std::get<ComponentContainer<Component>*>(required);
+	}
+
+	bool has_all(Entity e) const
+	{
+		return (container<Owned>().has(e) && ...) && (required_container<Required>().has(e) && ...);
+	}
+
+	// All owned containers have the group members in the same order, the first one tells the position
+	bool contains(Entity e) const
+	{
+		return has_all(e) && std::get<0>(containers)->index_of(e) < count;
+	}
+
+	void move_to(Entity e, size_t position)
+	{
+		(container<Owned>().swap_elements(container<Owned>().index_of(e), position), ...);
+	}
+
+	// An entity joins when it gets its last component and leaves when it loses the first one
+	template <typename Component>
+	void listen(ComponentContainer<Component>& c)
+	{
+		connections.emplace_back(c.on_construct, c.on_construct.connect([this](Entity e) {
+			if (has_all(e))
+				move_to(e, count++);
+		}));
+		connections.emplace_back(c.on_destroy, c.on_destroy.connect([this](Entity e) {
+			if (contains(e))
+				move_to(e, --count);
+		}));
+	}
+
+	template <typename Component>
+	void own()
+	{
+		ComponentContainer<Component>& c = container<Component>();
+		assert(!c.owned_by_group && "Container is already owned by a group");
+		c.owned_by_group = true;
+		listen(c);
+	}
+
+public:
+	BasicOwningGroup(Registry& registry)
+		: containers(&registry.template get<Owned>()...)
+		, required(&registry.template get<Required>()...)
+	{
+		(own<Owned>(), ...);
+		(listen(required_container<Required>()), ...);
+		// Pack the entities that are already complete, the ones moved back to position i were checked before
+		std::vector<Entity>& entities = std::get<0>(containers)->entities;
+		for (size_t i = 0; i < entities.size(); i++)
+			if (has_all(entities[i]))
+				move_to(entities[i], count++);
+	}
+
+	// Hands the containers back, they keep their current order
+	~BasicOwningGroup()
+	{
+		((container<Owned>().owned_by_group = false), ...);
+	}
+
+	// The containers call back into the group
+	BasicOwningGroup(const BasicOwningGroup&) = delete;
+	BasicOwningGroup& operator=(const BasicOwningGroup&) = delete;
+
+	size_t size() const { return count; }
+	Entity entity(size_t i) const { return std::get<0>(containers)->entities[i]; }
+
+	// Calls f(Entity, Owned&..., Required&...) for every member in group order, f must not add or remove the components of the group
+	template <typename Func>
+	void each(Func f)
+	{
+		for (size_t i = 0; i < count; i++)
+			f(entity(i), container<Owned>().components[i]..., required_container<Required>().get(entity(i))...);
+	}
+
+	// Moves a member behind all others and keeps the order of the rest, e.g. so that it is drawn last
+	void move_to_back(Entity e)
+	{
+		if (!contains(e))
+			return;
+		for (size_t i = std::get<0>(containers)->index_of(e); i + 1 < count; i++)
+			(container<Owned>().swap_elements(i, i + 1), ...);
+	}
+
+	// Sorts the members by compare(Entity, Entity) in place, all owned containers follow
+	template <class Compare>
+	void sort(Compare compare)
+	{
+		heap_sort(count,
+			[&](size_t i, size_t j) { return compare(entity(i), entity(j)); },
+			[&](size_t i, size_t j) { (container<Owned>().swap_elements(i, j), ...); });
+	}
+};
+
+// A group that owns all of its components
+template <class Registry, typename... Owned>
+using OwningGroup = BasicOwningGroup<Registry, With<>, Owned...>;
+
+// The position of T in the list Ts..., a compile error if T is not in the list
+template <typename T, typename... Ts>
+struct index_of_type;
+template <typename T, typename... Ts>
+struct index_of_type<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+template <typename T, typename U, typename... Ts>
+struct index_of_type<T, U, Ts...> : std::integral_constant<size_t, 1 + index_of_type<T, Ts...>::value> {};
+
+// A set of components with default values, e.g. what every rock starts with.
+// BasicRegistry::spawn_batch() gives each new entity a copy of all of them.
+template <typename... Components>
+struct Prefab
+{
+	std::tuple<Components...> defaults;
+
+	Prefab(Components... components) : defaults(std::move(components)...) {}
+};
+
+// A binary copy of the components of a registry, see BasicRegistry::snapshot() and restore().
+// The bytes are only meaningful to the same registry type built by the same compiler, pointers (Mesh*) are copied as they are.
+class Snapshot
+{
+	std::vector<char> bytes;
+public:
+	const char* data() const { return bytes.data(); }
+	size_t size() const { return bytes.size(); }
+
+	// Keeps the capacity, so snapshots taken into the same Snapshot stop allocating
+	void clear() { bytes.clear(); }
+	void reserve(size_t n) { bytes.reserve(n); }
+	void assign(const char* data, size_t n) { bytes.assign(data, data + n); }
+	void write(const void* data, size_t n) { bytes.insert(bytes.end(), (const char*)data, (const char*)data + n); }
+	template <typename T>
+	void write(const T& value) { write(&value, sizeof(T)); }
+};
+
+// Rewrites the entity handles inside a component when a snapshot is restored under new ids. Specialize it for components
+// that refer to other entities (see tiny_ecs_registry.hpp), remap(Entity) returns the new handle or null.
+template <typename Component>
+struct snapshot_traits
+{
+	template <typename Remap>
+	static void remap_entities(Component&, const Remap&) {}
+};
+
+// Trivially copyable components whose bytes point outside the registry (e.g. into an Arena) mean nothing in a snapshot,
+// specialize this as std::true_type to leave them out like the components that aren't trivially copyable
+template <typename Component>
+struct snapshot_excluded : std::false_type {};
+
+// Holds one ComponentContainer per type in 'Components' and the signature of every entity.
+// Component i owns bit i of the signature. The operations over all containers are fold expressions over
+// the type list, so they are unrolled at compile time and a container can't be forgotten.
+template <typename... Components>
+class BasicRegistry
+{
+	std::tuple<ComponentContainer<Components>...> containers;
+
+	// The ids of this registry's entities, registries don't share entities
+	EntityManager entity_manager;
+
+	// The components of every entity, see mask()
+	SignatureTable signatures;
+
+	// Advanced once per frame, the containers stamp their changes with it
+	uint32_t tick = 1;
+
+	static_assert(sizeof...(Components) <= sizeof(ComponentMask) * 8, "More component types than signature bits");
+
+public:
+	BasicRegistry()
+	{
+		((get<Components>().signatures = &signatures, get<Components>().signature_bit = mask<Components>(), get<Components>().tick = &tick), ...);
+	}
+
+	// The containers point into the registry
+	BasicRegistry(const BasicRegistry&) = delete;
+	BasicRegistry& operator=(const BasicRegistry&) = delete;
+
+	// The container of a component type, e.g. get<Motion>()
+	template <typename Component>
+	ComponentContainer<Component>& get() {
+		return std::get<ComponentContainer<Component>>(containers);
+	}
+
+	// A new entity without components, the ids of destroyed entities are re-used with a new generation
+	Entity create() {
+		return Entity(entity_manager.create());
+	}
+
+	// Whether 'e' was created by this registry and not destroyed since
+	bool is_alive(Entity e) const {
+		return entity_manager.is_alive(e);
+	}
+
+	// The signature bits of the component types, e.g. mask<Player, Health>()
+	template <typename... Cs>
+	static constexpr ComponentMask mask() {
+		return ((ComponentMask(1) << index_of_type<Cs, Components...>::value) | ... | ComponentMask(0));
+	}
+
+	// Systems remember the tick they last ran at and ask the containers for what changed since, see ComponentContainer::changed_since
+	uint32_t current_tick() const {
+		return tick;
+	}
+	uint32_t advance_tick() {
+		(get<Components>().end_frame(), ...);
+		return ++tick;
+	}
+
+	// The components an entity has, as a mask
+	ComponentMask signature(Entity e) const {
+		return signatures.get(e);
+	}
+
+	// Whether the entity has all of / any of the components in 'bits', see mask()
+	bool has_all(Entity e, ComponentMask bits) const {
+		return (signatures.get(e) & bits) == bits;
+	}
+	bool has_any(Entity e, ComponentMask bits) const {
+		return (signatures.get(e) & bits) != 0;
+	}
+
+	// How many components of each type to make room for. add<Cs...>(n) counts n entities that have all of Cs,
+	// so a profile is written as the entities a level spawns, e.g. add<Motion, RenderRequest, Obstacle>(50).
+	class CapacityProfile
+	{
+		size_t capacities[sizeof...(Components)] = {};
+	public:
+		template <typename... Cs>
+		CapacityProfile& add(size_t n) {
+			((capacities[index_of_type<Cs, Components...>::value] += n), ...);
+			return *this;
+		}
+
+		template <typename Component>
+		size_t get() const {
+			return capacities[index_of_type<Component, Components...>::value];
+		}
+	};
+
+	// Reserves every container for the profile, the containers report when they grow past it
+	void reserve(const CapacityProfile& profile) {
+		(get<Components>().reserve(profile.template get<Components>()), ...);
+	}
+
+	void clear_all_components() {
+		(get<Components>().clear(), ...);
+	}
+
+	void list_all_components() {
+		printf("Debug info on all registry entries:\n");
+		((get<Components>().size() > 0 ? (void)printf("%4d components of type %s\n", (int)get<Components>().size(), type_name(typeid(Components)).c_str()) : (void)0), ...);
+	}
+
+	// The stats of every container, in the order of the type list. Cheap enough to query every frame.
+	std::vector<ContainerStats> stats() {
+		std::vector<ContainerStats> all;
+		all.reserve(sizeof...(Components));
+		(all.push_back(get<Components>().stats()), ...);
+		return all;
+	}
+
+	void list_all_components_of(Entity e) {
+		printf("Debug info on components of entity %u:\n", (unsigned int)e);
+		ComponentMask signature = signatures.get(e);
+		(((signature & mask<Components>()) ? (void)printf("type %s\n", type_name(typeid(Components)).c_str()) : (void)0), ...);
+	}
+
+	// Destroys the entity, its id is recycled with a new generation so that stale handles to it stop matching.
+	// Only the containers in the entity's signature are touched.
+	void remove_all_components_of(Entity e) {
+		ComponentMask signature = signatures.get(e);
+		if (signature)
+			(((signature & mask<Components>()) ? get<Components>().remove(e) : (void)0), ...);
+		entity_manager.destroy(e);
+	}
+
+	// Destroys the entities like remove_all_components_of() but as one batch, every affected container drops all of its
+	// victims in a single pass that packs the remaining components. The list may hold duplicates and may be a
+	// container's own entities, e.g. destroy(registry.debugComponents.entities).
+	void destroy(const std::vector<Entity>& entities) {
+		destroy(entities.data(), entities.size());
+	}
+	void destroy(const Entity* entities, size_t count) {
+		victims.assign(entities, entities + count);
+		destroy_victims();
+	}
+
+	// Destroys every entity with at least one component for which predicate(Entity) holds, see destroy()
+	template <typename Predicate>
+	void destroy_if(Predicate predicate) {
+		victims.clear();
+		signatures.each([&](Entity e) {
+			if (predicate(e))
+				victims.push_back(e);
+		});
+		destroy_victims();
+	}
+
+	// Creates 'count' entities with the components of the prefab, then calls init(i, e) for the i-th new entity to set
+	// what differs between them. Each container grows once and receives the batch back to back, instead of the
+	// interleaved inserts of 'count' create functions. init must not call spawn_batch().
+	template <typename... Cs, typename Init>
+	void spawn_batch(const Prefab<Cs...>& prefab, size_t count, Init init) {
+		spawned.clear();
+		for (size_t i = 0; i < count; i++)
+			spawned.push_back(create());
+		(spawn_components<Cs>(std::get<Cs>(prefab.defaults)), ...);
+		for (size_t i = 0; i < count; i++)
+			init(i, spawned[i]);
+	}
+
+	// Writes the components of all entities to 'out', replacing its contents. Per container it stores the entities and,
+	// for trivially copyable components, the components as copied bytes, a page at a time. Tags only store their entities.
+	// Other components and those excluded by snapshot_excluded (e.g. HelpText, whose characters live in the level arena)
+	// are left out, and entities without components are not recorded.
+	void snapshot(Snapshot& out) {
+		out.clear();
+		out.reserve(2 * sizeof(uint32_t) + (section_bytes<Components>() + ...));
+		out.write(snapshot_magic);
+		out.write((uint32_t)sizeof...(Components));
+		(write_section<Components>(out), ...);
+	}
+
+	// Recreates the entities of a snapshot in this registry, next to the entities it already has. They get new ids,
+	// restored(e) maps a handle from the snapshotted registry to the new one and snapshot_traits remaps the handles inside
+	// components. Returns false without changing anything when the snapshot is of another registry type.
+	bool restore(const Snapshot& in) {
+		const char* cursor = in.data();
+		const char* end = cursor + in.size();
+		uint32_t magic = 0, type_count = 0;
+		if (!read(cursor, end, magic) || !read(cursor, end, type_count) || magic != snapshot_magic || type_count != sizeof...(Components))
+			return false;
+
+		// Check every section and give each snapshotted entity its new id before any component goes in,
+		// so that entity handles inside components can be remapped regardless of the container order
+		const char* sections[sizeof...(Components)];
+		if (!(scan_section<Components>(cursor, end, sections) && ...) || cursor != end)
+			return false;
+		restored_ids.clear();
+		(map_section_entities(sections[index_of_type<Components, Components...>::value]), ...);
+		(restore_section<Components>(sections[index_of_type<Components, Components...>::value]), ...);
+		return true;
+	}
+
+	// The entity a handle of the snapshotted registry was restored as by the last restore(), null if it wasn't in the snapshot
+	Entity restored(Entity e) const {
+		if (e.index() >= restored_ids.size() || restored_ids[e.index()].first != e)
+			return Entity::null();
+		return restored_ids[e.index()].second;
+	}
+
+	// All entities that have every one of the components, see View
+	template <typename... Cs>
+	View<BasicRegistry, type_list<Cs...>> view() {
+		return View<BasicRegistry, type_list<Cs...>>(*this);
+	}
+
+private:
+	static constexpr uint32_t snapshot_magic = 0x57534e50; // "WSNP"
+
+	// Each snapshot section is: the size of one component (0 for tags), the count, the entity ids and then the components
+	template <typename Component>
+	static constexpr bool snapshotted() {
+		return std::is_trivially_copyable<Component>::value && !snapshot_excluded<Component>::value;
+	}
+	template <typename Component>
+	static constexpr uint32_t snapshot_size() {
+		return std::is_empty<Component>::value ? 0 : (uint32_t)sizeof(Component);
+	}
+
+	template <typename Component>
+	size_t section_bytes() {
+		size_t count = snapshotted<Component>() ? get<Component>().size() : 0;
+		return 2 * sizeof(uint32_t) + count * (sizeof(Entity) + snapshot_size<Component>());
+	}
+
+	template <typename Component>
+	void write_section(Snapshot& out) {
+		ComponentContainer<Component>& container = get<Component>();
+		uint32_t count = snapshotted<Component>() ? (uint32_t)container.size() : 0;
+		out.write(snapshot_size<Component>());
+		out.write(count);
+		out.write(container.entities.data(), count * sizeof(Entity));
+		if (count > 0)
+			write_components(out, container.components);
+	}
+
+	template <typename Component, size_t PageSize>
+	static void write_components(Snapshot& out, PagedStorage<Component, PageSize>& storage) {
+		for (size_t first = 0, n = 0; first < storage.size(); first += n)
+		{
+			n = storage.contiguous_from(first);
+			out.write(&storage[first], n * sizeof(Component));
+		}
+	}
+	template <typename Component>
+	static void write_components(Snapshot&, TagStorage<Component>&) {}
+	// Storages with proxy references (MotionSoA) go element by element
+	template <class Storage>
+	static void write_components(Snapshot& out, Storage& storage) {
+		for (size_t i = 0; i < storage.size(); i++)
+			out.write(typename Storage::value_type(storage[i]));
+	}
+
+	template <typename T>
+	static bool read(const char*& cursor, const char* end, T& value) {
+		if ((size_t)(end - cursor) < sizeof(T))
+			return false;
+		memcpy(&value, cursor, sizeof(T));
+		cursor += sizeof(T);
+		return true;
+	}
+
+	// Records where the section starts and moves past it
+	template <typename Component>
+	static bool scan_section(const char*& cursor, const char* end, const char** sections) {
+		sections[index_of_type<Component, Components...>::value] = cursor;
+		uint32_t component_size = 0, count = 0;
+		if (!read(cursor, end, component_size) || !read(cursor, end, count) || component_size != snapshot_size<Component>())
+			return false;
+		size_t bytes = (size_t)count * (sizeof(Entity) + component_size);
+		if ((size_t)(end - cursor) < bytes)
+			return false;
+		cursor += bytes;
+		return true;
+	}
+
+	void map_section_entities(const char* section) {
+		uint32_t count = 0;
+		memcpy(&count, section + sizeof(uint32_t), sizeof(count));
+		const char* ids = section + 2 * sizeof(uint32_t);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Entity e;
+			memcpy(&e, ids + i * sizeof(Entity), sizeof(Entity));
+			if (e.index() >= restored_ids.size())
+				restored_ids.resize(e.index() + 1, { Entity::null(), Entity::null() });
+			if (restored_ids[e.index()].first != e)
+				restored_ids[e.index()] = { e, create() };
+		}
+	}
+
+	template <typename Component>
+	void restore_section(const char* section) {
+		if constexpr (snapshotted<Component>())
+		{
+			ComponentContainer<Component>& container = get<Component>();
+			uint32_t count = 0;
+			memcpy(&count, section + sizeof(uint32_t), sizeof(count));
+			const char* ids = section + 2 * sizeof(uint32_t);
+			const char* components = ids + (size_t)count * sizeof(Entity);
+			auto remap = [this](Entity e) { return restored(e); };
+			container.reserve_more(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				Entity e;
+				memcpy(&e, ids + i * sizeof(Entity), sizeof(Entity));
+				// The bytes are the component, trivially copyable types don't need a constructor call (Collision has no default one)
+				typename std::aligned_storage<sizeof(Component), alignof(Component)>::type bytes;
+				if (snapshot_size<Component>() > 0)
+					memcpy(&bytes, components + i * sizeof(Component), sizeof(Component));
+				Component& c = *std::launder(reinterpret_cast<Component*>(&bytes));
+				snapshot_traits<Component>::remap_entities(c, remap);
+				// Collisions hold an entity several times
+				container.insert(restored(e), c, false);
+			}
+		}
+	}
+
+	// Snapshot handle -> restored handle, indexed by the snapshot handle's index, see restored()
+	std::vector<std::pair<Entity, Entity>> restored_ids;
+
+	// The entities of the last spawn_batch(), kept to not allocate per batch
+	std::vector<Entity> spawned;
+
+	template <typename Component>
+	void spawn_components(const Component& value) {
+		ComponentContainer<Component>& container = get<Component>();
+		container.reserve_more(spawned.size());
+		for (Entity e : spawned)
+			container.insert(e, value);
+	}
+
+	// The batch of destroy() and the full id of each victim at its index, kept to not allocate per batch
+	std::vector<Entity> victims;
+	std::vector<unsigned int> victim_marks;
+
+	bool is_victim(Entity e) const {
+		return e.index() < victim_marks.size() && victim_marks[e.index()] == e;
+	}
+
+	void destroy_victims() {
+		// Mark the victims, dropping duplicates, and collect the containers they are in
+		ComponentMask affected = 0;
+		size_t unique = 0;
+		for (size_t i = 0; i < victims.size(); i++)
+		{
+			Entity e = victims[i];
+			if (is_victim(e) || e == Entity::null())
+				continue;
+			if (e.index() >= victim_marks.size())
+				victim_marks.resize(e.index() + 1, 0);
+			victim_marks[e.index()] = e;
+			victims[unique++] = e;
+			affected |= signatures.get(e);
+		}
+		victims.resize(unique);
+
+		(((affected & mask<Components>()) ? remove_victims<Components>() : (void)0), ...);
+
+		for (Entity e : victims)
+		{
+			victim_marks[e.index()] = 0;
+			entity_manager.destroy(e);
+		}
+	}
+
+	template <typename Component>
+	void remove_victims() {
+		ComponentContainer<Component>& container = get<Component>();
+		// The listeners see the components before they go, a group moves its victims out of its packed range
+		if (!container.on_destroy.empty())
+			for (Entity e : victims)
+				if (container.has(e))
+					container.on_destroy.emit(e);
+		container.remove_if([this](Entity e) { return is_victim(e); });
 	}
 };
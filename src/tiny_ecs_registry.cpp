@@ -1,3 +1,5 @@
+// internal
 #include "tiny_ecs_registry.hpp"
 
-ECSRegistry registry;
\ No newline at end of file
+// ECSRegistry is header only, every system gets the registry it works on passed in (see main.cpp) so that several
+// independent worlds, e.g. a benchmark or a tool next to the game, can exist side by side
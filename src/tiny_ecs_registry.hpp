@@ -1,121 +1,175 @@
 #pragma once
 #include <vector>
 
+#include "arena.hpp"
 #include "tiny_ecs.hpp"
 #include "components.hpp"
+#include "motion_soa.hpp"
 
-class ECSRegistry
+// Most entities share their render request, mesh and color with many others (every rock, every scorpion), these
+// containers store each distinct value once, see SharedStorage
+template <>
+struct component_storage<RenderRequest>
 {
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface*> registry_list;
+	typedef SharedStorage<RenderRequest> type;
+};
+
+template <>
+struct component_storage<Mesh*>
+{
+	typedef SharedStorage<Mesh*> type;
+};
+
+template <>
+struct component_storage<vec3>
+{
+	typedef SharedStorage<vec3> type;
+};
+
+// All components this game has, the registry creates one container for each type in this list
+typedef BasicRegistry<
+	DeathTimer,
+	Motion,
+	Collision,
+	Player,
+	Persistent,
+	GroundHeight,
+	Mesh*,
+	RenderRequest,
+	ScreenState,
+	Eatable,
+	Deadly,
+	Scorpion,
+	Snake,
+	Spider,
+	Enemy,
+	Boss,
+	ForestBoss,
+	DesertBoss,
+	IceBoss,
+	DebugComponent,
+	HelpText,
+	vec3,
+	LightUp,
+	Bullet,
+	Grenade,
+	Snowball,
+	Explosion,
+	Tornado,
+	Gun,
+	Parent,
+	Sword,
+	Health,
+	Obstacle,
+	Item,
+	DamageTimer,
+	IceMonster1,
+	IceMonster2
+> ECSRegistryBase;
+
+// The components that refer to other entities, restoring a snapshot points them at the restored entities
+template <>
+struct snapshot_traits<Collision>
+{
+	template <typename Remap>
+	static void remap_entities(Collision& collision, const Remap& remap) { collision.other = remap(collision.other); }
+};
+
+template <>
+struct snapshot_traits<Parent>
+{
+	template <typename Remap>
+	static void remap_entities(Parent& parent, const Remap& remap) { parent.entity = remap(parent.entity); }
+};
+
+// HelpText::s points into the level arena
+template <>
+struct snapshot_excluded<HelpText> : std::true_type {};
 
+class ECSRegistry : public ECSRegistryBase
+{
 public:
-	// Manually created list of all components this game has
-	ComponentContainer<DeathTimer> deathTimers;
-	ComponentContainer<Motion> motions;
-	ComponentContainer<Collision> collisions;
-	ComponentContainer<Player> players;
-	ComponentContainer<Mesh*> meshPtrs;
-	ComponentContainer<RenderRequest> renderRequests;
-	ComponentContainer<ScreenState> screenStates;
-	ComponentContainer<Eatable> eatables;
-	ComponentContainer<Deadly> deadlys;
-    ComponentContainer<Scorpion> scorpions;
-    ComponentContainer<Snake> snakes;
-    ComponentContainer<Spider> spiders;
-	ComponentContainer<Enemy> enemies;
-	ComponentContainer<Boss> bosses;
-    ComponentContainer<ForestBoss> forestBosses;
-    ComponentContainer<DesertBoss> desertBosses;
-	ComponentContainer<IceBoss> iceBosses;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<HelpText> helpTexts;
-	ComponentContainer<vec3> colors;
-	ComponentContainer<LightUp> lightUps;
-    ComponentContainer<Bullet> bullets;
-    ComponentContainer<Grenade> grenades;
-	ComponentContainer<Snowball> snowballs;
-    ComponentContainer<Explosion> explosions;
-    ComponentContainer<Tornado> tornados;
-    ComponentContainer<Gun> guns;
-    ComponentContainer<Sword> swords;
-    ComponentContainer<Health> healths;
-	ComponentContainer<Obstacle> obstacles;
-    ComponentContainer<Item> items;
-    ComponentContainer<DamageTimer> damageTimers;
-	ComponentContainer<IceMonster1> ice1Monsters;
-	ComponentContainer<IceMonster2> ice2Monsters;
+	// Named shortcuts to the containers, registry.motions is the same as registry.get<Motion>()
+	ComponentContainer<DeathTimer>& deathTimers = get<DeathTimer>();
+	ComponentContainer<Motion>& motions = get<Motion>();
+	ComponentContainer<Collision>& collisions = get<Collision>();
+	ComponentContainer<Player>& players = get<Player>();
+	ComponentContainer<Persistent>& persistents = get<Persistent>();
+	ComponentContainer<GroundHeight>& groundHeights = get<GroundHeight>();
+	ComponentContainer<Mesh*>& meshPtrs = get<Mesh*>();
+	ComponentContainer<RenderRequest>& renderRequests = get<RenderRequest>();
+	ComponentContainer<ScreenState>& screenStates = get<ScreenState>();
+	ComponentContainer<Eatable>& eatables = get<Eatable>();
+	ComponentContainer<Deadly>& deadlys = get<Deadly>();
+    ComponentContainer<Scorpion>& scorpions = get<Scorpion>();
+    ComponentContainer<Snake>& snakes = get<Snake>();
+    ComponentContainer<Spider>& spiders = get<Spider>();
+	ComponentContainer<Enemy>& enemies = get<Enemy>();
+	ComponentContainer<Boss>& bosses = get<Boss>();
+    ComponentContainer<ForestBoss>& forestBosses = get<ForestBoss>();
+    ComponentContainer<DesertBoss>& desertBosses = get<DesertBoss>();
+	ComponentContainer<IceBoss>& iceBosses = get<IceBoss>();
+	ComponentContainer<DebugComponent>& debugComponents = get<DebugComponent>();
+	ComponentContainer<HelpText>& helpTexts = get<HelpText>();
+	ComponentContainer<vec3>& colors = get<vec3>();
+	ComponentContainer<LightUp>& lightUps = get<LightUp>();
+    ComponentContainer<Bullet>& bullets = get<Bullet>();
+    ComponentContainer<Grenade>& grenades = get<Grenade>();
+	ComponentContainer<Snowball>& snowballs = get<Snowball>();
+    ComponentContainer<Explosion>& explosions = get<Explosion>();
+    ComponentContainer<Tornado>& tornados = get<Tornado>();
+    ComponentContainer<Gun>& guns = get<Gun>();
+    ComponentContainer<Parent>& parents = get<Parent>();
+    ComponentContainer<Sword>& swords = get<Sword>();
+    ComponentContainer<Health>& healths = get<Health>();
+	ComponentContainer<Obstacle>& obstacles = get<Obstacle>();
+    ComponentContainer<Item>& items = get<Item>();
+    ComponentContainer<DamageTimer>& damageTimers = get<DamageTimer>();
+	ComponentContainer<IceMonster1>& ice1Monsters = get<IceMonster1>();
+	ComponentContainer<IceMonster2>& ice2Monsters = get<IceMonster2>();
+
+	// Structural changes recorded by the systems while they iterate, applied in the main loop after each system
+	CommandBuffer<ECSRegistry> commands;
 
+	// The entities with a RenderRequest and a Motion, packed at the front of renderRequests for the renderer.
+	// The motions are only looked up, so the group never moves them and a MotionRef stays valid across inserts.
+	BasicOwningGroup<ECSRegistry, With<Motion>, RenderRequest> renderables{ *this };
 
+	// The gun entity, kept up to date by the guns container instead of reading guns.entities[0]
+	Entity gun = Entity::null();
 
     std::vector<RenderRequest> player_sprites;
     std::vector<RenderRequest> explosion_sprites;
     std::vector<RenderRequest> dragon_sprites;
     std::vector<RenderRequest> tornado_sprites;
 
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
-	ECSRegistry()
-	{
-		registry_list.push_back(&lightUps);
-		registry_list.push_back(&deathTimers);
-		registry_list.push_back(&motions);
-		registry_list.push_back(&collisions);
-		registry_list.push_back(&players);
-		registry_list.push_back(&meshPtrs);
-		registry_list.push_back(&renderRequests);
-		registry_list.push_back(&screenStates);
-		registry_list.push_back(&eatables);
-		registry_list.push_back(&deadlys);
-        registry_list.push_back(&scorpions);
-        registry_list.push_back(&snakes);
-        registry_list.push_back(&spiders);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&colors);
-        registry_list.push_back(&bullets);
-        registry_list.push_back(&grenades);
-        registry_list.push_back(&explosions);
-        registry_list.push_back(&tornados);
-        registry_list.push_back(&guns);
-        registry_list.push_back(&swords);
-        registry_list.push_back(&enemies);
-        registry_list.push_back(&bosses);
-        registry_list.push_back(&forestBosses);
-        registry_list.push_back(&desertBosses);
-		registry_list.push_back(&ice1Monsters);
-		registry_list.push_back(&ice2Monsters);
-		registry_list.push_back(&iceBosses);
-		registry_list.push_back(&snowballs);
-
-        registry_list.push_back(&healths);
-		registry_list.push_back(&obstacles);
-        registry_list.push_back(&items);
-        registry_list.push_back(&damageTimers);
-	}
+	// Payloads that belong to the current level (the HelpText strings), released in one go by restart_game
+	Arena level_arena;
 
-	void clear_all_components() {
-		for (ContainerInterface* reg : registry_list)
-			reg->clear();
-	}
-
-	void list_all_components() {
-		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface* reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
-	}
-
-	void list_all_components_of(Entity e) {
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface* reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
+	// The stats of the containers followed by the sprite lists, which should keep their size once the sprites are loaded,
+	// and the level arena in bytes
+	std::vector<ContainerStats> stats()
+	{
+		std::vector<ContainerStats> all = ECSRegistryBase::stats();
+		all.push_back(vector_stats("player_sprites", player_sprites));
+		all.push_back(vector_stats("explosion_sprites", explosion_sprites));
+		all.push_back(vector_stats("dragon_sprites", dragon_sprites));
+		all.push_back(vector_stats("tornado_sprites", tornado_sprites));
+		ContainerStats arena;
+		arena.name = "level_arena";
+		arena.size = level_arena.bytes_used();
+		arena.peak_size = level_arena.peak_bytes();
+		arena.capacity = arena.component_bytes = level_arena.bytes_reserved();
+		all.push_back(arena);
+		return all;
 	}
 
-	void remove_all_components_of(Entity e) {
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
+	ECSRegistry() : commands(*this)
+	{
+		guns.on_construct.connect([this](Entity e) { gun = e; });
+		guns.on_destroy.connect([this](Entity e) {
+			if (e == gun)
+				gun = Entity::null();
+		});
 	}
 };
-
-extern ECSRegistry registry;
\ No newline at end of file
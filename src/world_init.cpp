@@ -2,16 +2,16 @@
 #include "tiny_ecs_registry.hpp"
 #include <iostream>
 
-Entity createProtagonist(RenderSystem* renderer, vec2 pos)
+Entity createProtagonist(ECSRegistry& registry, RenderSystem* renderer, vec2 pos)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Store a reference to the potentially re-used mesh object
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
     registry.meshPtrs.emplace(entity, &mesh);
 
     // Setting initial motion values
-    Motion& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.position = pos;
     motion.angle = 0.0f;
     motion.velocity = { 0.f, 0.f };
@@ -21,22 +21,28 @@ Entity createProtagonist(RenderSystem* renderer, vec2 pos)
 
     // Create and (empty) Chicken component to be able to refer to all eagles
     registry.players.emplace(entity);
+    registry.groundHeights.emplace(entity).y = PROTAGONIST_GROUND_Y;
+    // The protagonist carries its health and position into the next level
+    registry.persistents.emplace(entity);
 
     Health& protagonistHealth = registry.healths.emplace(entity);
     protagonistHealth.health = PROTAGONIST_HEALTH;
 
-    registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST21,
-                              EFFECT_ASSET_ID::TEXTURED,
-                              GEOMETRY_BUFFER_ID::SPRITE});
-    registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST22,
-                              EFFECT_ASSET_ID::TEXTURED,
-                              GEOMETRY_BUFFER_ID::SPRITE});
-    registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST23,
-                              EFFECT_ASSET_ID::TEXTURED,
-                              GEOMETRY_BUFFER_ID::SPRITE});
-    registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST24,
-                              EFFECT_ASSET_ID::TEXTURED,
-                              GEOMETRY_BUFFER_ID::SPRITE});
+    // The sprites are shared, only the first protagonist loads them
+    if (registry.player_sprites.empty()) {
+        registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST21,
+                                  EFFECT_ASSET_ID::TEXTURED,
+                                  GEOMETRY_BUFFER_ID::SPRITE});
+        registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST22,
+                                  EFFECT_ASSET_ID::TEXTURED,
+                                  GEOMETRY_BUFFER_ID::SPRITE});
+        registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST23,
+                                  EFFECT_ASSET_ID::TEXTURED,
+                                  GEOMETRY_BUFFER_ID::SPRITE});
+        registry.player_sprites.push_back({ TEXTURE_ASSET_ID::PROTAGONST24,
+                                  EFFECT_ASSET_ID::TEXTURED,
+                                  GEOMETRY_BUFFER_ID::SPRITE});
+    }
 
 
     registry.renderRequests.insert(
@@ -48,9 +54,9 @@ Entity createProtagonist(RenderSystem* renderer, vec2 pos)
     return entity;
 }
 
-Entity createGrenade(RenderSystem* renderer, Entity bossE, Entity playerE)
+Entity createGrenade(ECSRegistry& registry, RenderSystem* renderer, Entity bossE, Entity playerE)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     Motion bossMotion = registry.motions.get(bossE);
     Motion playerMotion = registry.motions.get(playerE);
@@ -68,7 +74,7 @@ Entity createGrenade(RenderSystem* renderer, Entity bossE, Entity playerE)
     float deltaVy = 50.0f;
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.0f;
     if (playerMotion.position.y - bossMotion.position.y < 0) {
         motion.velocity = direction * vec2({ -velX, velY });
@@ -99,9 +105,9 @@ Entity createGrenade(RenderSystem* renderer, Entity bossE, Entity playerE)
 }
 
 
-Entity createSnowball(RenderSystem* renderer, Entity bossE, Entity playerE)
+Entity createSnowball(ECSRegistry& registry, RenderSystem* renderer, Entity bossE, Entity playerE)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     Motion bossMotion = registry.motions.get(bossE);
     Motion playerMotion = registry.motions.get(playerE);
@@ -119,7 +125,7 @@ Entity createSnowball(RenderSystem* renderer, Entity bossE, Entity playerE)
     float deltaVy = 50.0f;
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.0f;
     if (playerMotion.position.y - bossMotion.position.y < 0) {
         motion.velocity = direction * vec2({ -velX, velY });
@@ -150,12 +156,12 @@ Entity createSnowball(RenderSystem* renderer, Entity bossE, Entity playerE)
 }
 
 
-Entity createExplosion(RenderSystem* renderer, vec2 pos)
+Entity createExplosion(ECSRegistry& registry, RenderSystem* renderer, vec2 pos)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Setting initial motion values
-    Motion& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.position = pos;
     motion.angle = 0.0f;
     motion.velocity = { 0.f, 0.f };
@@ -165,36 +171,38 @@ Entity createExplosion(RenderSystem* renderer, vec2 pos)
     Explosion explosion = registry.explosions.emplace(entity);
     explosion.timeSwitch = 500;
 
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION1,
-                                        EFFECT_ASSET_ID::TEXTURED,
-                                        GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION2,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION3,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION4,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION5,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION6,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION7,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION8,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION9,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
-    registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION10,
-                                           EFFECT_ASSET_ID::TEXTURED,
-                                           GEOMETRY_BUFFER_ID::SPRITE});
+    if (registry.explosion_sprites.empty()) {
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION1,
+                                            EFFECT_ASSET_ID::TEXTURED,
+                                            GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION2,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION3,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION4,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION5,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION6,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION7,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION8,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION9,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+        registry.explosion_sprites.push_back({ TEXTURE_ASSET_ID::EXPLOSION10,
+                                               EFFECT_ASSET_ID::TEXTURED,
+                                               GEOMETRY_BUFFER_ID::SPRITE});
+    }
 
     registry.renderRequests.insert(
             entity,
@@ -205,9 +213,9 @@ Entity createExplosion(RenderSystem* renderer, vec2 pos)
     return entity;
 }
 
-Entity createTornado(RenderSystem* renderer, Entity bossE, Entity playerE)
+Entity createTornado(ECSRegistry& registry, RenderSystem* renderer, Entity bossE, Entity playerE)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     Motion bossMotion = registry.motions.get(bossE);
     Motion playerMotion = registry.motions.get(playerE);
@@ -223,7 +231,7 @@ Entity createTornado(RenderSystem* renderer, Entity bossE, Entity playerE)
     float velY = playerGrenadeDistY / tornadoTimeps;
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.0f;
     motion.velocity = direction * vec2({ -velX, velY });
     motion.position = bossMotion.position;
@@ -265,9 +273,9 @@ Entity createTornado(RenderSystem* renderer, Entity bossE, Entity playerE)
     return entity;
 }
 
-Entity createSpider(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createSpider(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -276,7 +284,7 @@ Entity createSpider(RenderSystem* renderer, vec2 position, vec2 velocity)
     vec2 bug_dim = vec2(578, 421) * 0.2f;
 
 	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = velocity + vec2({ -150.f, 0});
 	motion.position = position + vec2(0, bug_dim.y/4);
@@ -301,16 +309,16 @@ Entity createSpider(RenderSystem* renderer, vec2 position, vec2 velocity)
 
 }
 
-Entity createEagle(RenderSystem* renderer, vec2 position)
+Entity createEagle(ECSRegistry& registry, RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
 	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 100.f };
 	motion.position = position;
@@ -330,16 +338,16 @@ Entity createEagle(RenderSystem* renderer, vec2 position)
 }
 
 
-Entity createScorpion(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createScorpion(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
 	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = velocity + vec2({ -155.f, 0});
 	motion.position = position;
@@ -364,16 +372,16 @@ Entity createScorpion(RenderSystem* renderer, vec2 position, vec2 velocity)
 }
 
 #if 0
-Entity createForestBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createForestBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
 	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = velocity + vec2({ -100.f, 0 });
 	motion.position = position;
@@ -399,16 +407,16 @@ Entity createForestBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
 
 #endif
 
-Entity createForestBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createForestBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
 	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = velocity + vec2({ -150.f, 0 });
 	motion.position = position;
@@ -433,12 +441,12 @@ Entity createForestBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
 	return entity;
 }
 
-Entity createDesertBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createDesertBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.f;
     motion.velocity = velocity + vec2({ -150.f, 0 });
     motion.position = position;
@@ -454,15 +462,17 @@ Entity createDesertBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
     auto& health = registry.healths.emplace(entity);
     health.health = DESERT_BOSS_HEALTH;
 
-    registry.dragon_sprites.push_back({ TEXTURE_ASSET_ID::DRAGON1,
-                                        EFFECT_ASSET_ID::TEXTURED,
-                                        GEOMETRY_BUFFER_ID::SPRITE});
-    registry.dragon_sprites.push_back({ TEXTURE_ASSET_ID::DRAGON2,
-                                        EFFECT_ASSET_ID::TEXTURED,
-                                        GEOMETRY_BUFFER_ID::SPRITE});
-    registry.dragon_sprites.push_back({ TEXTURE_ASSET_ID::DRAGON3,
-                                        EFFECT_ASSET_ID::TEXTURED,
-                                        GEOMETRY_BUFFER_ID::SPRITE});
+    if (registry.dragon_sprites.empty()) {
+        registry.dragon_sprites.push_back({ TEXTURE_ASSET_ID::DRAGON1,
+                                            EFFECT_ASSET_ID::TEXTURED,
+                                            GEOMETRY_BUFFER_ID::SPRITE});
+        registry.dragon_sprites.push_back({ TEXTURE_ASSET_ID::DRAGON2,
+                                            EFFECT_ASSET_ID::TEXTURED,
+                                            GEOMETRY_BUFFER_ID::SPRITE});
+        registry.dragon_sprites.push_back({ TEXTURE_ASSET_ID::DRAGON3,
+                                            EFFECT_ASSET_ID::TEXTURED,
+                                            GEOMETRY_BUFFER_ID::SPRITE});
+    }
 
     registry.renderRequests.insert(
             entity,
@@ -474,16 +484,16 @@ Entity createDesertBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
     return entity;
 }
 
-Entity createIceBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createIceBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
     registry.meshPtrs.emplace(entity, &mesh);
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.f;
     motion.velocity = velocity + vec2({ -150.f, 0 });
     motion.position = position;
@@ -508,16 +518,16 @@ Entity createIceBoss(RenderSystem* renderer, vec2 position, vec2 velocity)
     return entity;
 }
 
-Entity createIceMonster1(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createIceMonster1(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
     registry.meshPtrs.emplace(entity, &mesh);
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.f;
     motion.velocity = velocity + vec2({ -150.f, 0 });
     motion.position = position;
@@ -542,16 +552,16 @@ Entity createIceMonster1(RenderSystem* renderer, vec2 position, vec2 velocity)
     return entity;
 }
 
-Entity createIceMonster2(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createIceMonster2(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
     registry.meshPtrs.emplace(entity, &mesh);
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.f;
     motion.velocity = velocity + vec2({ -150.f, 0 });
     motion.position = position;
@@ -576,16 +586,16 @@ Entity createIceMonster2(RenderSystem* renderer, vec2 position, vec2 velocity)
     return entity;
 }
 
-Entity createSnake(RenderSystem* renderer, vec2 position, vec2 velocity)
+Entity createSnake(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
 	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = velocity + vec2({ -155.f, 0 });
 	motion.position = position;
@@ -608,9 +618,9 @@ Entity createSnake(RenderSystem* renderer, vec2 position, vec2 velocity)
 	return entity;
 }
 
-Entity createLine(vec2 position, vec2 scale)
+Entity createLine(ECSRegistry& registry, vec2 position, vec2 scale)
 {
-	Entity entity = Entity();
+	Entity entity = registry.create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	registry.renderRequests.insert(
@@ -620,7 +630,7 @@ Entity createLine(vec2 position, vec2 scale)
 		 GEOMETRY_BUFFER_ID::DEBUG_LINE });
 
 	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -630,40 +640,47 @@ Entity createLine(vec2 position, vec2 scale)
 	return entity;
 }
 
-Entity createRock(RenderSystem* renderer, vec2 pos, GEOMETRY_BUFFER_ID rock, float scaleMultiplier, vec2 velocity)
+void createRocks(ECSRegistry& registry, RenderSystem* renderer, const std::vector<RockPlacement>& rocks, vec2 velocity, vec3 color)
 {
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh& mesh = renderer->getMesh(rock);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Setting initial motion values
-	Motion& motion = registry.motions.emplace(entity);
+	// What all rocks share, the mesh and the size are filled in per rock
+	Motion motion;
 	motion.angle = 0.f;
 	motion.velocity = velocity;
-	motion.scale = mesh.original_size * scaleMultiplier;
-	motion.scale.y *= -1;
-	pos.x += abs(motion.scale.x) / 2;
-	pos.y -= abs(motion.scale.y) / 2;
-	motion.position = pos;
-
-	registry.obstacles.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
+	Prefab<Mesh*, Motion, Obstacle, RenderRequest, vec3> rock(
+		nullptr,
+		motion,
+		Obstacle(),
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::EGG,
-			rock });
-
-	return entity;
+			GEOMETRY_BUFFER_ID::GEOMETRY_COUNT },
+		color);
+
+	registry.spawn_batch(rock, rocks.size(), [&](size_t i, Entity entity) {
+		const RockPlacement& placement = rocks[i];
+
+		// Store a reference to the potentially re-used mesh object
+		Mesh& mesh = renderer->getMesh(placement.rock);
+		registry.meshPtrs.get(entity) = &mesh;
+		RenderRequest request = registry.renderRequests.get(entity);
+		request.used_geometry = placement.rock;
+		registry.renderRequests.get(entity) = request;
+
+		MotionRef motion = registry.motions.get(entity);
+		motion.scale = mesh.original_size * placement.scaleMultiplier;
+		motion.scale.y *= -1;
+		vec2 pos = placement.pos;
+		pos.x += abs(motion.scale.x) / 2;
+		pos.y -= abs(motion.scale.y) / 2;
+		motion.position = pos;
+	});
 }
 
-Entity createEgg(vec2 pos, vec2 size)
+Entity createEgg(ECSRegistry& registry, vec2 pos, vec2 size)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Setting initial motion values
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -680,9 +697,9 @@ Entity createEgg(vec2 pos, vec2 size)
 	return entity;
 }
 
-Entity createBackground(RenderSystem* renderer, vec2 position,  TEXTURE_ASSET_ID background)
+Entity createBackground(ECSRegistry& registry, RenderSystem* renderer, vec2 position,  TEXTURE_ASSET_ID background)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Assuming the background uses a sprite mesh that covers the entire screen.
 	// The mesh could be a simple quad that's scaled to the size of the screen.
@@ -691,7 +708,7 @@ Entity createBackground(RenderSystem* renderer, vec2 position,  TEXTURE_ASSET_ID
 
 	// Setting initial motion values, the position would be the center of the screen.
 	// Assuming motion system is used for positioning entities.
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.position = position;
 	motion.angle = 0.0f; // No rotation.
 	motion.velocity = { 0.f, 0.f }; // Static, no movement.
@@ -707,13 +724,13 @@ Entity createBackground(RenderSystem* renderer, vec2 position,  TEXTURE_ASSET_ID
 	return entity;
 }
 
-Entity createForeground(RenderSystem* renderer, vec2 position, vec2 size, TEXTURE_ASSET_ID foreground) {
-	auto entity = Entity();
+Entity createForeground(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 size, TEXTURE_ASSET_ID foreground) {
+	auto entity = registry.create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.position = position;
 	motion.angle = 0.0f;
 	motion.velocity = { 0.f, 0.f };
@@ -728,13 +745,13 @@ Entity createForeground(RenderSystem* renderer, vec2 position, vec2 size, TEXTUR
 	return entity;
 }
 
-Entity createForeground2(RenderSystem* renderer, vec2 position, vec2 size) {
-	auto entity = Entity();
+Entity createForeground2(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 size) {
+	auto entity = registry.create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.position = position;
 	motion.angle = 0.0f;
 	motion.velocity = { 0.f, 0.f };
@@ -750,9 +767,9 @@ Entity createForeground2(RenderSystem* renderer, vec2 position, vec2 size) {
 }
 
 
-Entity createHelpText(RenderSystem* renderer, vec2 position)
+Entity createHelpText(ECSRegistry& registry, RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = registry.create();
 
 	// Assuming the background uses a sprite mesh that covers the entire screen.
 	// The mesh could be a simple quad that's scaled to the size of the screen.
@@ -761,7 +778,7 @@ Entity createHelpText(RenderSystem* renderer, vec2 position)
 
 	// Setting initial motion values, the position would be the center of the screen.
 	// Assuming motion system is used for positioning entities.
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.position = position;
 	motion.angle = 0.0f; // No rotation.
 	motion.velocity = { 0.f, 0.f }; // Static, no movement.
@@ -779,29 +796,50 @@ Entity createHelpText(RenderSystem* renderer, vec2 position)
 }
 
 
-Entity createGun(RenderSystem* renderer)
+void attach(ECSRegistry& registry, Entity child, Entity parent, vec2 offset)
+{
+    Parent& link = registry.parents.emplace(child);
+    link.entity = parent;
+    link.offset = offset;
+    link.scale = abs(vec2(registry.motions.get(child).scale));
+    if (registry.parents.has(parent))
+        link.depth = registry.parents.get(parent).depth + 1;
+
+    // Place the child right away instead of at the next step
+    follow_parent(link, registry.motions.get(parent), registry.motions.get(child));
+}
+
+void follow_parent(const Parent& link, const Motion& parentMotion, MotionRef motion)
+{
+    // -1 on the axes the parent is mirrored on, e.g. x when it faces left
+    vec2 facing = vec2(parentMotion.scale.x < 0 ? -1.f : 1.f, parentMotion.scale.y < 0 ? -1.f : 1.f);
+    motion.position = parentMotion.position + facing * link.offset;
+    motion.velocity = parentMotion.velocity;
+    motion.scale = facing * link.scale;
+}
+
+Entity createGun(ECSRegistry& registry, RenderSystem* renderer)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
     registry.meshPtrs.emplace(entity, &mesh);
 
-    Entity protagonist = registry.players.entities[0];
-    Motion& protagonistMotion = registry.motions.get(protagonist);
-
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.0f;
-    motion.velocity = protagonistMotion.velocity;
-    motion.position = protagonistMotion.position;
 
     // Setting initial values, scale is negative to make it face the opposite way
     motion.scale = vec2({GUN_BB_WIDTH, GUN_BB_HEIGHT});
 
+    // The gun is held by the protagonist, it takes over the protagonist's position and facing
+    attach(registry, entity, registry.players.entities[0]);
+
     // Create and (empty) scorpion component to be able to refer to all scorpions
     Gun& gun = registry.guns.emplace(entity);
     gun.damage = BULLET_DAMAGE;
+    registry.persistents.emplace(entity);
     registry.renderRequests.insert(
             entity,
             { TEXTURE_ASSET_ID::GUN,
@@ -811,21 +849,21 @@ Entity createGun(RenderSystem* renderer)
     return entity;
 }
 
-Entity createBullet(RenderSystem* renderer)
+Entity createBullet(ECSRegistry& registry, RenderSystem* renderer)
 {
-    auto entity = Entity();
+    auto entity = registry.create();
 
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
     registry.meshPtrs.emplace(entity, &mesh);
 
-    Entity gun = registry.guns.entities[0];
+    Entity gun = registry.gun;
     Motion gunMotion = registry.motions.get(gun);
 
     vec2 direction = (gunMotion.scale / abs(gunMotion.scale));
 
     // Initialize the motion
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0.0f;
     motion.velocity = direction * vec2({ 400.f, 0 });
     motion.position = gunMotion.position;
@@ -845,8 +883,8 @@ Entity createBullet(RenderSystem* renderer)
 }
 
 // spawns a Sword
-Entity createSword(RenderSystem* renderer, Entity parent, vec3 color) {
-    Entity entity = Entity();
+Entity createSword(ECSRegistry& registry, RenderSystem* renderer, Entity parent, vec3 color) {
+    Entity entity = registry.create();
     
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -856,7 +894,7 @@ Entity createSword(RenderSystem* renderer, Entity parent, vec3 color) {
     Motion parentMotion = registry.motions.get(parent);
 
     // Initialize motion for sword
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0;
     motion.velocity = vec2(0, 0); // TODO calculate random velocity for the object
     motion.position = parentMotion.position + vec2(24, 0); // offset the sword 10 pixels
@@ -879,8 +917,8 @@ Entity createSword(RenderSystem* renderer, Entity parent, vec3 color) {
 }
 
 // spawns a Shield
-Entity createShield(RenderSystem* renderer, Entity parent, vec3 color) {
-    Entity entity = Entity();
+Entity createShield(ECSRegistry& registry, RenderSystem* renderer, Entity parent, vec3 color) {
+    Entity entity = registry.create();
     
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -890,7 +928,7 @@ Entity createShield(RenderSystem* renderer, Entity parent, vec3 color) {
     Motion parentMotion = registry.motions.get(parent);
 
     // Initialize motion for sword
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0;
     motion.velocity = vec2(0, 0); // TODO calculate random velocity for the object
     motion.position = parentMotion.position - vec2(24, 0); // offset the sword 10 pixels
@@ -915,8 +953,8 @@ Entity createShield(RenderSystem* renderer, Entity parent, vec3 color) {
 }
 
 // spawns a Heart
-Entity createHeart(RenderSystem* renderer, Entity parent, vec3 color) {
-    Entity entity = Entity();
+Entity createHeart(ECSRegistry& registry, RenderSystem* renderer, Entity parent, vec3 color) {
+    Entity entity = registry.create();
     
     // Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -926,7 +964,7 @@ Entity createHeart(RenderSystem* renderer, Entity parent, vec3 color) {
     Motion parentMotion = registry.motions.get(parent);
 
     // Initialize motion for sword
-    auto& motion = registry.motions.emplace(entity);
+    MotionRef motion = registry.motions.emplace(entity);
     motion.angle = 0;
     motion.velocity = vec2(0, 0); // TODO calculate random velocity for the object
     motion.position = parentMotion.position - vec2(24, 0); // offset the sword 10 pixels
@@ -959,18 +997,18 @@ void createInventoryTexture(RenderSystem* renderer, TEXTURE_ASSET_ID id, vec2 po
     renderer->immediate_textures.push_back(texture);
 }
 
-Entity createHelpText(const std::string& s, vec2 pos, vec2 velocity)
+Entity createHelpText(ECSRegistry& registry, std::string_view s, vec2 pos, vec2 velocity)
 {
-	Entity entity = Entity();
+	Entity entity = registry.create();
 
 	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = velocity;
 	motion.position = pos;
 	//motion.scale = { 1.f, 1.f };
 
 	HelpText& text = registry.helpTexts.emplace(entity);
-	text.s = s;
+	text.s = registry.level_arena.copy(s);
 	return entity;
 }
@@ -2,6 +2,7 @@
 
 #include "common.hpp"
 #include "tiny_ecs.hpp"
+#include "tiny_ecs_registry.hpp"
 #include "render_system.hpp"
 
 // These are hard coded to the dimensions of the entity texture
@@ -31,7 +32,8 @@ const float ICE2_BB_WIDTH = 0.6f * 360.f;
 
 const float PROTAGONIST_BB_WIDTH = 0.6f * 65.f; // approximate
 const float PROTAGONIST_BB_HEIGHT = 0.6f * 170.f; // approximate
-extern float protagonist_center_pos_y;
+// Where the protagonist's center is when it stands on the ground, see GroundHeight
+const float PROTAGONIST_GROUND_Y = GROUND_POSITION - PROTAGONIST_BB_HEIGHT / 2;
 const float GUN_BB_WIDTH = 0.6f * 100.f;
 const float GUN_BB_HEIGHT = 0.6f * 75.f;
 const float BULLET_BB_WIDTH = 0.6f * 50.f;
@@ -70,52 +72,63 @@ const unsigned int DESERT_BOSS_DAMAGE = 10;
 const unsigned int ICE_BOSS_DAMAGE = 15;
 
 // background
-Entity createBackground(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID background);
+Entity createBackground(ECSRegistry& registry, RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID background);
 // foreground
-Entity createForeground(RenderSystem* renderer, vec2 position, vec2 size, TEXTURE_ASSET_ID foreground);
-Entity createForeground2(RenderSystem* renderer, vec2 position, vec2 size);
-Entity createHelpText(RenderSystem* renderer, vec2 position);
+Entity createForeground(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 size, TEXTURE_ASSET_ID foreground);
+Entity createForeground2(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 size);
+Entity createHelpText(ECSRegistry& registry, RenderSystem* renderer, vec2 position);
 // the player
-Entity createProtagonist(RenderSystem* renderer, vec2 pos);
+Entity createProtagonist(ECSRegistry& registry, RenderSystem* renderer, vec2 pos);
 // the prey
-Entity createSpider(RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createSpider(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
 // the enemy
-Entity createEagle(RenderSystem* renderer, vec2 position);
+Entity createEagle(ECSRegistry& registry, RenderSystem* renderer, vec2 position);
 // scorpion
-Entity createScorpion(RenderSystem* renderer, vec2 position, vec2 velocity);
-Entity createIceMonster1(RenderSystem* renderer, vec2 position, vec2 velocity);
-Entity createIceMonster2(RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createScorpion(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createIceMonster1(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createIceMonster2(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
 
 //snake
-Entity createSnake(RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createSnake(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
 // boss
-Entity createForestBoss(RenderSystem* renderer, vec2 position, vec2 velocity);
-Entity createDesertBoss(RenderSystem* renderer, vec2 position, vec2 velocity);
-Entity createIceBoss(RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createForestBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createDesertBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
+Entity createIceBoss(ECSRegistry& registry, RenderSystem* renderer, vec2 position, vec2 velocity);
 
 // a red line for debugging purposes
-Entity createLine(vec2 position, vec2 size);
-// a rock
-Entity createRock(RenderSystem* renderer, vec2 pos, GEOMETRY_BUFFER_ID rock, float scaleMultiplier, vec2 velocity);
+Entity createLine(ECSRegistry& registry, vec2 position, vec2 size);
+// where a rock goes, its mesh and how much the mesh is scaled
+struct RockPlacement
+{
+	vec2 pos;
+	GEOMETRY_BUFFER_ID rock;
+	float scaleMultiplier;
+};
+// rocks, spawned as one batch
+void createRocks(ECSRegistry& registry, RenderSystem* renderer, const std::vector<RockPlacement>& rocks, vec2 velocity, vec3 color);
 // a egg
-Entity createEgg(vec2 pos, vec2 size);
-Entity createGun(RenderSystem* renderer);
-Entity createBullet(RenderSystem* renderer);
+Entity createEgg(ECSRegistry& registry, vec2 pos, vec2 size);
+// makes 'child' follow 'parent' at 'offset', keeping the child's current size. Attach parents before their children.
+void attach(ECSRegistry& registry, Entity child, Entity parent, vec2 offset = { 0.f, 0.f });
+// the transform of an attached child, derived from its parent's
+void follow_parent(const Parent& link, const Motion& parentMotion, MotionRef motion);
+Entity createGun(ECSRegistry& registry, RenderSystem* renderer);
+Entity createBullet(ECSRegistry& registry, RenderSystem* renderer);
 // spawns a Sword
-Entity createSword(RenderSystem* renderer, Entity parent, vec3 color);
+Entity createSword(ECSRegistry& registry, RenderSystem* renderer, Entity parent, vec3 color);
 // spawns a Shield
-Entity createShield(RenderSystem* renderer, Entity parent, vec3 color);
+Entity createShield(ECSRegistry& registry, RenderSystem* renderer, Entity parent, vec3 color);
 // spawns a Heart
-Entity createHeart(RenderSystem* renderer, Entity parent, vec3 color);
+Entity createHeart(ECSRegistry& registry, RenderSystem* renderer, Entity parent, vec3 color);
 // a texture to render in the inventory
 void createInventoryTexture(RenderSystem* renderer, TEXTURE_ASSET_ID id, vec2 position, vec2 scale, vec3 color = vec3(1));
 // a text
-Entity createHelpText(const std::string& s, vec2 pos, vec2 velocity);
+Entity createHelpText(ECSRegistry& registry, std::string_view s, vec2 pos, vec2 velocity);
 
-Entity createGrenade(RenderSystem* renderer, Entity boss, Entity player);
+Entity createGrenade(ECSRegistry& registry, RenderSystem* renderer, Entity boss, Entity player);
 
-Entity createSnowball(RenderSystem* renderer, Entity boss, Entity player);
+Entity createSnowball(ECSRegistry& registry, RenderSystem* renderer, Entity boss, Entity player);
 
-Entity createExplosion(RenderSystem* renderer, vec2 pos);
+Entity createExplosion(ECSRegistry& registry, RenderSystem* renderer, vec2 pos);
 
-Entity createTornado(RenderSystem* renderer, Entity bossE, Entity playerE);
+Entity createTornado(ECSRegistry& registry, RenderSystem* renderer, Entity bossE, Entity playerE);
@@ -34,50 +34,19 @@ const size_t OBSTACLE_DELAY_MS = 1000 * 3;
 const size_t MAX_FOREST_BOSSES = 1;
 const size_t MAX_DESERT_BOSSES = 1;
 const size_t MAX_ICE_BOSSES = 1;
+const size_t MAX_ROCKS = 50;
+// Upper bounds for the capacity profiles, e.g. a bullet every 500 ms lives for a few seconds
+const size_t MAX_LIVE_BULLETS = 16;
+const size_t MAX_LIVE_EXPLOSIONS = 8;
+const size_t MAX_COLLISIONS_PER_STEP = 64;
 
-float protagonist_center_pos_y = GROUND_POSITION - PROTAGONIST_BB_HEIGHT / 2;
-float fps;
-int currentForestBosses;
-int currentDesertBosses;
-int currentIceBosses;
-int scorpionsSpawned;
-int ice1Spawned;
-int ice2Spawned;
-int snakesSpawned;
-int forestEnemySpawned;
-int obstaclesSpawned;
-bool chickenFalling;
-bool keyPressed;
-bool forestBossAlive;
-bool forestbossKilled = false;
-bool desertBossAlive;
-bool desertBossKilled = false;
-bool iceBossAlive;
-bool iceBossKilled = false;
-float timeSinceBulletSpawn = 0;
-float timeSinceGrenadeSpawn = 0;
-float timeSinceSnowballSpawn = 0;
-float timeSinceTornadoSpawn = 0;
-float timeSinceExplosionSwitch = 0;
-float timeSinceDragonSwitch = 0;
-float grenadeSpawnTime = 5000;
-float snowballSpawnTime = 5000;
-float tornadoSpawnTime = 5000;
-int currentPlayerSprite = 0;
-int currentExplosionSprite = 0;
-int currentDragonSprite = 0;
-int prevDragonSprite = 1;
-bool playerMoving = false;
-float timeSincePlayerWalk = 500;
-int numRocks = 0;
-vec2 foregroundVelocity;
-Entity forestBoss;
-Entity desertBoss;
-Entity iceBoss;
+const float grenadeSpawnTime = 5000;
+const float snowballSpawnTime = 5000;
+const float tornadoSpawnTime = 5000;
 
 // List of color for the items
 #define MAX_ARMOR_LEVEL 4
-vec3 color_list[MAX_ARMOR_LEVEL] = {
+const vec3 color_list[MAX_ARMOR_LEVEL] = {
 	// bronze
 	{205 / 255.f, 127 / 255.f, 50 / 255.f},
 	// silver
@@ -89,8 +58,10 @@ vec3 color_list[MAX_ARMOR_LEVEL] = {
 };
 
 // Create the bug world
-WorldSystem::WorldSystem()
-	: points(0)
+WorldSystem::WorldSystem(ECSRegistry& registry, ThreadPool& threads)
+	: registry(registry)
+	, threads(threads)
+	, points(0)
 	, scorpionsKilled(0)
     , snakesKilled(0)
     , spiderKilled(0)
@@ -101,6 +72,26 @@ WorldSystem::WorldSystem()
     , desertBossesKilled(0) {
 	// Seeding rng with random device
 	rng = std::default_random_engine(std::random_device()());
+
+	// The boss counts follow the boss components
+	listen(registry.forestBosses.on_construct, [this](Entity) { forestBossesAlive++; });
+	listen(registry.forestBosses.on_destroy, [this](Entity) { forestBossesAlive--; });
+	listen(registry.desertBosses.on_construct, [this](Entity) { desertBossesAlive++; });
+	listen(registry.desertBosses.on_destroy, [this](Entity) { desertBossesAlive--; });
+	listen(registry.iceBosses.on_construct, [this](Entity) { iceBossesAlive++; });
+	listen(registry.iceBosses.on_destroy, [this](Entity) { iceBossesAlive--; });
+	// A killed boss gets a DeathTimer and stays in the registry until it runs out, it doesn't count meanwhile.
+	// Destroying the entity removes the DeathTimer before the boss component, so the count goes back up first.
+	listen(registry.deathTimers.on_construct, [this](Entity e) {
+		forestBossesAlive -= this->registry.forestBosses.has(e);
+		desertBossesAlive -= this->registry.desertBosses.has(e);
+		iceBossesAlive -= this->registry.iceBosses.has(e);
+	});
+	listen(registry.deathTimers.on_destroy, [this](Entity e) {
+		forestBossesAlive += this->registry.forestBosses.has(e);
+		desertBossesAlive += this->registry.desertBosses.has(e);
+		iceBossesAlive += this->registry.iceBosses.has(e);
+	});
 }
 
 WorldSystem::~WorldSystem() {
@@ -214,6 +205,17 @@ GLFWwindow* WorldSystem::create_window() {
 void WorldSystem::updateInventory() {
 	// Update inventory
 
+	// The inventory only shows the player's Health and the Gun, it is rebuilt when one of them changed since the
+	// last build and otherwise the renderer gets the textures of the last build again
+	Entity gunEnt = registry.gun;
+	assert(registry.healths.has(currentLevel.player_protagonist));
+	assert(registry.guns.has(gunEnt));
+	if (!registry.healths.changed_since(currentLevel.player_protagonist, inventory_tick) && !registry.guns.changed_since(gunEnt, inventory_tick)) {
+		renderer->immediate_textures.insert(renderer->immediate_textures.end(), inventory_textures.begin(), inventory_textures.end());
+		return;
+	}
+	inventory_tick = registry.current_tick();
+	size_t first_texture = renderer->immediate_textures.size();
 
 #define MAX_BOX_IN_INVENTORY 6
 #define BOX_DIMENSION 64
@@ -250,12 +252,9 @@ void WorldSystem::updateInventory() {
 
 	// Draw items in the inventory
 
-    assert(registry.healths.has(currentLevel.player_protagonist));
     Health health = registry.healths.get(currentLevel.player_protagonist);
     unsigned int num_shields = health.armor_level; //clamp((int)floorf(health.health / (int)PROTAGONIST_HEALTH), 0, (int)MAX_ARMOR_LEVEL);
 
-    Entity gunEnt = registry.guns.entities[0];
-    assert(registry.guns.has(gunEnt));
     Gun& gun = registry.guns.get(gunEnt);
     unsigned int num_damage = clamp((int)floorf(gun.damage / BULLET_DAMAGE), 0, (int)MAX_ARMOR_LEVEL);
         
@@ -292,20 +291,22 @@ void WorldSystem::updateInventory() {
     }
 	*/
 
+	inventory_textures.assign(renderer->immediate_textures.begin() + first_texture, renderer->immediate_textures.end());
 }
 
 void WorldSystem::createExplosionAnimation() {
     for (Entity explosionE : registry.explosions.entities) {
         Explosion explosion = registry.explosions.get(explosionE);
-        RenderRequest& explosionRR = registry.renderRequests.get(explosionE);
+        RenderRequest explosionRR = registry.renderRequests.get(explosionE);
         if (timeSinceExplosionSwitch >= explosion.timeSwitch) {
             timeSinceExplosionSwitch = 0;
             if (currentExplosionSprite == registry.explosion_sprites.size()) {
                 currentExplosionSprite = 0;
-                registry.remove_all_components_of(explosionE);
-                return;
+                registry.commands.destroy(explosionE);
+                continue;
             }
             explosionRR.used_texture = registry.explosion_sprites[currentExplosionSprite].used_texture;
+            registry.renderRequests.get(explosionE) = explosionRR;
             currentExplosionSprite++;
         }
     }
@@ -314,7 +315,7 @@ void WorldSystem::createExplosionAnimation() {
 void WorldSystem::createDragonAnimation() {
     for (Entity dragonE : registry.desertBosses.entities) {
         DesertBoss dragon = registry.desertBosses.get(dragonE);
-        RenderRequest& desertBossRR = registry.renderRequests.get(dragonE);
+        RenderRequest desertBossRR = registry.renderRequests.get(dragonE);
         if (timeSinceDragonSwitch >= dragon.timeSwitch) {
             timeSinceDragonSwitch = 0;
             int prev = prevDragonSprite;
@@ -331,6 +332,7 @@ void WorldSystem::createDragonAnimation() {
                 currentDragonSprite--;
             }
             desertBossRR.used_texture = registry.dragon_sprites[currentDragonSprite].used_texture;
+            registry.renderRequests.get(dragonE) = desertBossRR;
         }
     }
 }
@@ -339,12 +341,13 @@ void WorldSystem::createTornadoAnimation() {
     for (Entity tornadoE : registry.tornados.entities) {
         if (registry.tornados.has(tornadoE)) {
             Tornado& tornado = registry.tornados.get(tornadoE);
-            RenderRequest& tornadoRR = registry.renderRequests.get(tornadoE);
+            RenderRequest tornadoRR = registry.renderRequests.get(tornadoE);
             if (tornado.timeSinceSwitch >= tornado.timeSwitch) {
                 tornado.timeSinceSwitch = 0;
                 tornado.spriteIndex++;
                 tornado.spriteIndex = tornado.spriteIndex % registry.tornado_sprites.size();
                 tornadoRR.used_texture = registry.tornado_sprites[tornado.spriteIndex].used_texture;
+                registry.renderRequests.get(tornadoE) = tornadoRR;
             }
         }
     }
@@ -386,8 +389,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
         if (grenadeMotion.position.y >= (GROUND_POSITION - (GRENADE_BB_HEIGHT / 2))) {
             timeSinceExplosionSwitch = 0;
             Mix_PlayChannel(-1, explosion_sound, 0);
-            createExplosion(renderer, grenadeMotion.position);
-            registry.remove_all_components_of(grenadeE);
+            createExplosion(registry, renderer, grenadeMotion.position);
+            registry.commands.destroy(grenadeE);
         } 
 		/*else if (grenadeMotion.position.y <= (GRENADE_BB_HEIGHT / 2)) {
             registry.remove_all_components_of(grenadeE);
@@ -399,7 +402,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		Snowball snowball = registry.snowballs.get(snowballE);
 		Motion snowballMotion = registry.motions.get(snowballE);
 		if (snowballMotion.position.y >= (GROUND_POSITION - (SNOWBALL_BB_HEIGHT / 2))) {
-			registry.remove_all_components_of(snowballE);
+			registry.commands.destroy(snowballE);
 		} 
 		/*else if (snowballMotion.position.y <= (SNOWBALL_BB_HEIGHT / 2)) {
             registry.remove_all_components_of(snowballE);
@@ -412,39 +415,39 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
         Tornado tornado = registry.tornados.get(tornadoE);
         Motion tornadoMotion = registry.motions.get(tornadoE);
         if (tornadoMotion.position.y >= (GROUND_POSITION - (TORNADO_BB_HEIGHT / 2))) {
-            registry.remove_all_components_of(tornadoE);
+            registry.commands.destroy(tornadoE);
         } else if (tornadoMotion.position.y <= (TORNADO_BB_HEIGHT / 2)) {
-            registry.remove_all_components_of(tornadoE);
+            registry.commands.destroy(tornadoE);
         }
     }
 
     Entity player_protagonist = currentLevel.player_protagonist;
 
     // Spawn a grenade after every grenadeSpawnTime and if forest boss is still alive
-    if (forestBossAlive && (timeSinceGrenadeSpawn >= grenadeSpawnTime)) {
+    if (forestBossesAlive > 0 && !registry.commands.is_pending_destroy(forestBoss) && (timeSinceGrenadeSpawn >= grenadeSpawnTime)) {
         timeSinceGrenadeSpawn = 0;
-        createGrenade(renderer, forestBoss, player_protagonist);
+        createGrenade(registry, renderer, forestBoss, player_protagonist);
     }
 
 	// Spawn a snowball after every snowball spawn time and if ice boss is still alive
-	if (iceBossAlive && (timeSinceSnowballSpawn >= snowballSpawnTime)) {
+	if (iceBossesAlive > 0 && !registry.commands.is_pending_destroy(iceBoss) && (timeSinceSnowballSpawn >= snowballSpawnTime)) {
 		timeSinceSnowballSpawn = 0;
-		createSnowball(renderer, iceBoss, player_protagonist);
+		createSnowball(registry, renderer, iceBoss, player_protagonist);
 	}
 
     // Spawn a grenade after every tornadoSpawnTime and if desert boss is still alive
-    if (desertBossAlive && (timeSinceTornadoSpawn >= tornadoSpawnTime)) {
+    if (desertBossesAlive > 0 && !registry.commands.is_pending_destroy(desertBoss) && (timeSinceTornadoSpawn >= tornadoSpawnTime)) {
         // (registry.tornados.entities.size() == 0)
         timeSinceTornadoSpawn = 0;
-        createTornado(renderer, desertBoss, player_protagonist);
+        createTornado(registry, renderer, desertBoss, player_protagonist);
     }
 
     createExplosionAnimation();
     createDragonAnimation();
     createTornadoAnimation();
 
-	// Animate player movement
-	RenderRequest& playerRR = registry.renderRequests.get(player_protagonist);
+	// Animate player movement, the render request is shared so the changed copy is written back
+	RenderRequest playerRR = registry.renderRequests.get(player_protagonist);
 	if (!playerMoving) {
 		playerRR.used_texture = registry.player_sprites[3].used_texture;
 		timeSincePlayerWalk = 500;
@@ -457,6 +460,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			timeSincePlayerWalk = 500;
 		}
 	}
+	registry.renderRequests.get(player_protagonist) = playerRR;
 
 	// Animate player damage
 	if (registry.damageTimers.has(player_protagonist)) {
@@ -469,8 +473,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			registry.colors.emplace_with_duplicates(player_protagonist, animColor);
 		}
 		else {
-			vec3& color = registry.colors.get(player_protagonist);
-			color = animColor;
+			registry.colors.get(player_protagonist) = animColor;
 		}
 	}
 	else {
@@ -484,8 +487,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	}
 	glfwSetWindowTitle(window, title_ss.str().c_str());
 	// Remove debug info from the last step
-	while (registry.debugComponents.entities.size() > 0)
-		registry.remove_all_components_of(registry.debugComponents.entities.back());
+	registry.destroy(registry.debugComponents.entities);
 
 	// Removing out of screen entities
 	auto& motions_registry = registry.motions;
@@ -496,10 +498,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
     Entity foreground_entity = currentLevel.foreground_entity;
     Entity foreground_entity2 = currentLevel.foreground_entity2;
 
-	Motion& backgroundmotion1 = registry.motions.get(background_entity);
-	Motion& backgroundmotion2 = registry.motions.get(background_entity2);
+	MotionRef backgroundmotion1 = registry.motions.get(background_entity);
+	MotionRef backgroundmotion2 = registry.motions.get(background_entity2);
 
-	Motion& playerMotion = registry.motions.get(player_protagonist);
+	MotionRef playerMotion = registry.motions.get(player_protagonist);
 
 
 	if (backgroundmotion1.position.x + backgroundmotion1.scale.x / 2 < playerMotion.position.x - static_cast<float>(window_width_px) / 2) { // First background is out of view
@@ -528,8 +530,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	}
 	*/
 
-	Motion& foregroundmotion1 = registry.motions.get(foreground_entity);
-	Motion& foregroundmotion2 = registry.motions.get(foreground_entity2);
+	MotionRef foregroundmotion1 = registry.motions.get(foreground_entity);
+	MotionRef foregroundmotion2 = registry.motions.get(foreground_entity2);
 
 	if (foregroundmotion1.position.x + foregroundmotion1.scale.x / 2 < playerMotion.position.x - static_cast<float>(window_width_px) / 2) { // First background is out of view
 		foregroundmotion1.position.x = foregroundmotion2.position.x + foregroundmotion2.scale.x;
@@ -549,7 +551,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	// (the containers exchange the last element with the current)
 	/*
 	for (int i = (int)motions_registry.components.size()-1; i>=0; --i) {
-		Motion& motion = motions_registry.components[i];
+		MotionRef motion = motions_registry.components[i];
 		if (motion.position.x + abs(motion.scale.x) < 0.f) {
 			if(!registry.players.has(motions_registry.entities[i])) // don't remove the player
 				registry.remove_all_components_of(motions_registry.entities[i]);
@@ -561,13 +563,13 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	// Check if player is standing on an obstacle
 	bool isUnder = false;
 	for (auto obstacle : registry.obstacles.entities) {
-		Motion& playerMotion = registry.motions.get(player_protagonist);
+		MotionRef playerMotion = registry.motions.get(player_protagonist);
 		float playerLeft = playerMotion.position.x - PROTAGONIST_BB_WIDTH / 2;
 		float playerRight = playerMotion.position.x + PROTAGONIST_BB_WIDTH / 2;
 		float playerTop = playerMotion.position.y - PROTAGONIST_BB_HEIGHT / 2;
 		float playerBottom = playerMotion.position.y + PROTAGONIST_BB_HEIGHT / 2;
 		Mesh* mesh = registry.meshPtrs.get(obstacle);
-		Motion& obstacleMotion = registry.motions.get(obstacle);
+		MotionRef obstacleMotion = registry.motions.get(obstacle);
 		/*float angleRad = -playerMotion.angle;
 		glm::mat2 rotationMatrix = glm::mat2(cos(angleRad), -sin(angleRad), sin(angleRad), cos(angleRad));*/
 		for (auto v : mesh->vertices) {
@@ -587,7 +589,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	}
 
 	if (!isUnder)
-		protagonist_center_pos_y = GROUND_POSITION - PROTAGONIST_BB_HEIGHT / 2;
+		registry.groundHeights.get(player_protagonist).y = PROTAGONIST_GROUND_Y;
 
 	//auto& foreground_velocity = registry.motions.get(foreground_entity).velocity;
 	foregroundVelocity = registry.motions.get(foreground_entity).velocity;
@@ -598,99 +600,94 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 	// make scorpions follow player
 	if (!registry.deathTimers.has(player_protagonist)) {
-		for (Entity ent : registry.deadlys.entities) {
-			if (!registry.deathTimers.has(ent)) {
-
-				Motion& deadlyMotion = registry.motions.get(ent);
-				vec2 deadlyPosition = deadlyMotion.position;
-
-				Motion& playerMotion = registry.motions.get(player_protagonist);
-				vec2 playerPosition = playerMotion.position;
-				bool isRockBetween = false;
-				for (Entity rock : registry.obstacles.entities) {
-					Motion& rockMotion = registry.motions.get(rock);
-					vec2 rockPosition = rockMotion.position;
-
-					if ((rockPosition.x < playerPosition.x && rockPosition.x > deadlyPosition.x) || (rockPosition.x > playerPosition.x && rockPosition.x < deadlyPosition.x)) {
-						isRockBetween = true;
-						break;
-					}
-
+		// copy the position, createLine below adds motions and may move the container
+		vec2 playerPosition = registry.motions.get(player_protagonist).position;
+		registry.view<Deadly, Motion>().exclude<DeathTimer>().each([&](Entity ent, Deadly& deadly, MotionRef deadlyMotion) {
+			vec2 deadlyPosition = deadlyMotion.position;
+
+			bool isRockBetween = false;
+			for (Entity rock : registry.obstacles.entities) {
+				MotionRef rockMotion = registry.motions.get(rock);
+				vec2 rockPosition = rockMotion.position;
+
+				if ((rockPosition.x < playerPosition.x && rockPosition.x > deadlyPosition.x) || (rockPosition.x > playerPosition.x && rockPosition.x < deadlyPosition.x)) {
+					isRockBetween = true;
+					break;
 				}
 
-				Deadly& deadly = registry.deadlys.get(ent);
-				if (isRockBetween) {
-					deadly.followingPlayer = false;
-					continue;
-				}
-				deadly.followingPlayer = true;
+			}
 
-				// calculate direction from scorpion to player
-				vec2 directionToPlayer = playerPosition - deadlyPosition;
-				vec2 horizontalDirectionToPlayer = vec2(directionToPlayer.x, 0.0f);
+			if (isRockBetween) {
+				deadly.followingPlayer = false;
+				return;
+			}
+			deadly.followingPlayer = true;
 
-				// normalize the direction vec2
-				vec2 normalizedDirection = normalize(horizontalDirectionToPlayer);
+			// calculate direction from scorpion to player
+			vec2 directionToPlayer = playerPosition - deadlyPosition;
+			vec2 horizontalDirectionToPlayer = vec2(directionToPlayer.x, 0.0f);
 
-				/*float deadlySpeed = 35.0f;
-				if (abs(directionToPlayer.x) > 350) {
-					deadlySpeed = 42.0f;
-				}
-				*/
+			// normalize the direction vec2
+			vec2 normalizedDirection = normalize(horizontalDirectionToPlayer);
 
-				deadlyMotion.velocity = foregroundVelocity + normalizedDirection * abs(deadlyMotion.velocity);
+			/*float deadlySpeed = 35.0f;
+			if (abs(directionToPlayer.x) > 350) {
+				deadlySpeed = 42.0f;
+			}
+			*/
+
+			deadlyMotion.velocity = foregroundVelocity + normalizedDirection * abs(deadlyMotion.velocity);
 
                 if (directionToPlayer.x > 0) {
                     deadlyMotion.scale = vec2(-abs(deadlyMotion.scale.x), abs(deadlyMotion.scale.y));
 #if 0
-					if (bossAlive) {
-						deadlyMotion.scale = vec2(-BOSS_BB_WIDTH, BOSS_BB_HEIGHT); // facing right
-					}
-					else {
-						deadlyMotion.scale = vec2(-SCORPION_BB_WIDTH, SCORPION_BB_HEIGHT); // facing right
-					}
-#endif
+				if (bossAlive) {
+					deadlyMotion.scale = vec2(-BOSS_BB_WIDTH, BOSS_BB_HEIGHT); // facing right
 				}
 				else {
+					deadlyMotion.scale = vec2(-SCORPION_BB_WIDTH, SCORPION_BB_HEIGHT); // facing right
+				}
+#endif
+			}
+			else {
                     deadlyMotion.scale = vec2(abs(deadlyMotion.scale.x), abs(deadlyMotion.scale.y));
 #if 0
-					if (bossAlive) {
-						deadlyMotion.scale = vec2(BOSS_BB_WIDTH, BOSS_BB_HEIGHT); // facing left
-					}
-					else {
-						deadlyMotion.scale = vec2(SCORPION_BB_WIDTH, SCORPION_BB_HEIGHT); // facing left
-					}
-#endif
+				if (bossAlive) {
+					deadlyMotion.scale = vec2(BOSS_BB_WIDTH, BOSS_BB_HEIGHT); // facing left
 				}
+				else {
+					deadlyMotion.scale = vec2(SCORPION_BB_WIDTH, SCORPION_BB_HEIGHT); // facing left
+				}
+#endif
+			}
 
-				float barLength = (deadlyMotion.scale.x - 20.0f);
+			float barLength = (deadlyMotion.scale.x - 20.0f);
 
                 if (registry.healths.has(ent)) {
-                    if ((forestBossAlive && registry.forestBosses.has(ent)) || (iceBossAlive && registry.iceBosses.has(ent)) || (desertBossAlive && registry.desertBosses.has(ent))) {
+                    if (registry.forestBosses.has(ent) || registry.iceBosses.has(ent) || registry.desertBosses.has(ent)) {
                         Health& bossHealth = registry.healths.get(ent);
-						if (forestBossAlive) {
-							barLength *= float(bossHealth.health / static_cast<double>(40));
-						}
-						else if (desertBossAlive) {
-							barLength *= float(bossHealth.health / static_cast<double>(50));
-						}
-						else {
-							barLength *= float(bossHealth.health / static_cast<double>(60));
-						}
+					if (registry.forestBosses.has(ent)) {
+						barLength *= float(bossHealth.health / static_cast<double>(40));
+					}
+					else if (registry.desertBosses.has(ent)) {
+						barLength *= float(bossHealth.health / static_cast<double>(50));
 					}
+					else {
+						barLength *= float(bossHealth.health / static_cast<double>(60));
+					}
+				}
                     else {
                         Health& enemyHealth = registry.healths.get(ent);
                         barLength *= float(enemyHealth.health / static_cast<double>(2));
-						printf("Enemy health: %d\n", enemyHealth.health);
-						printf("Bar length: %f\n", barLength);
+					printf("Enemy health: %d\n", enemyHealth.health);
+					printf("Bar length: %f\n", barLength);
 
                     }
                 }
 
-				// draw top line
-				createLine({ deadlyMotion.position.x  , deadlyMotion.position.y - deadlyMotion.scale.y * 0.5f - 10.0f }, { barLength, 2.0f });
-			}
-		}
+			// draw top line
+			createLine(registry, { deadlyMotion.position.x  , deadlyMotion.position.y - deadlyMotion.scale.y * 0.5f - 10.0f }, { barLength, 2.0f });
+		});
 	}
 
     // Extract current level information
@@ -728,8 +725,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		else {
 			xPos = xPos - static_cast<float>(window_width_px) / 2;	// spawn on the left side of the screen
 		}
-		createScorpion(renderer, vec2(xPos, GROUND_POSITION - SCORPION_BB_HEIGHT / 3), foregroundVelocity); // div by 3 to make scorpion legs on platform
-		// createScorpion(renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
+		createScorpion(registry, renderer, vec2(xPos, GROUND_POSITION - SCORPION_BB_HEIGHT / 3), foregroundVelocity); // div by 3 to make scorpion legs on platform
+		// createScorpion(registry, renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
 		scorpionsSpawned++;
 	}
 
@@ -747,8 +744,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		else {
 			xPos = xPos - static_cast<float>(window_width_px) / 2;	// spawn on the left side of the screen
 		}
-		createSpider(renderer, vec2(xPos, GROUND_POSITION - SCORPION_BB_HEIGHT / 3), foregroundVelocity); // div by 3 to make scorpion legs on platform
-		// createScorpion(renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
+		createSpider(registry, renderer, vec2(xPos, GROUND_POSITION - SCORPION_BB_HEIGHT / 3), foregroundVelocity); // div by 3 to make scorpion legs on platform
+		// createScorpion(registry, renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
 		
         forestEnemySpawned++;
 	}
@@ -757,11 +754,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		next_forest_boss_spawn -= elapsed_ms_since_last_update * current_speed;
 		// we are ready for the boss
 		if (next_forest_boss_spawn < 0.f) {
-			forestBoss = createForestBoss(renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2 + 100.0f, GROUND_POSITION - FOREST_BOSS_BB_HEIGHT / 2), foregroundVelocity);
+			forestBoss = createForestBoss(registry, renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2 + 100.0f, GROUND_POSITION - FOREST_BOSS_BB_HEIGHT / 2), foregroundVelocity);
             timeSinceGrenadeSpawn = 0;
-            createGrenade(renderer, forestBoss, player_protagonist);
+            createGrenade(registry, renderer, forestBoss, player_protagonist);
             currentForestBosses++;
-			forestBossAlive = true;
 		}
 
 	}
@@ -772,8 +768,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			// spawn snakes
 			next_snake_spawn = (SNAKE_DELAY_MS / 2) + uniform_dist(rng) * (SNAKE_DELAY_MS / 2);
 			// - 100 is out of bounds at the top
-			createSnake(renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2, GROUND_POSITION - SNAKE_BB_HEIGHT / 3 + 10.0f), foregroundVelocity); // div by 3 to make scorpion legs on platform
-			// createScorpion(renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
+			createSnake(registry, renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2, GROUND_POSITION - SNAKE_BB_HEIGHT / 3 + 10.0f), foregroundVelocity); // div by 3 to make scorpion legs on platform
+			// createScorpion(registry, renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
 			snakesSpawned++;
 		}
 	}
@@ -783,11 +779,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
         // we are ready for the boss
         if (next_boss_spawn < 0.f) {
             timeSinceDragonSwitch = 0;
-            desertBoss = createDesertBoss(renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2 + 100.0f, GROUND_POSITION - 250.f), foregroundVelocity);
+            desertBoss = createDesertBoss(registry, renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2 + 100.0f, GROUND_POSITION - 250.f), foregroundVelocity);
             currentDesertBosses++;
-            desertBossAlive = true;
             timeSinceTornadoSpawn = 0;
-            createTornado(renderer, desertBoss, player_protagonist);
+            createTornado(registry, renderer, desertBoss, player_protagonist);
         }
     }
 
@@ -805,8 +800,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		else {
 			xPos = xPos - static_cast<float>(window_width_px) / 2;	// spawn on the left side of the screen
 		}
-		createIceMonster1(renderer, vec2(xPos, GROUND_POSITION - ICE1_BB_HEIGHT / 3 - 5.0f), foregroundVelocity); // div by 3 to make scorpion legs on platform
-		// createScorpion(renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
+		createIceMonster1(registry, renderer, vec2(xPos, GROUND_POSITION - ICE1_BB_HEIGHT / 3 - 5.0f), foregroundVelocity); // div by 3 to make scorpion legs on platform
+		// createScorpion(registry, renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
 		ice1Spawned++;
 	}
 
@@ -815,8 +810,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		if (ice2Spawned < MAX_ICE_2 && next_ice_monster_2_spawn < 0.f) {
 			next_ice_monster_2_spawn = (ICE2_DELAY_MS / 2) + uniform_dist(rng) * (ICE2_DELAY_MS / 2);
 			// - 100 is out of bounds at the top
-			createIceMonster2(renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2, GROUND_POSITION - ICE2_BB_HEIGHT / 3), foregroundVelocity); // div by 3 to make scorpion legs on platform
-			// createScorpion(renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
+			createIceMonster2(registry, renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2, GROUND_POSITION - ICE2_BB_HEIGHT / 3), foregroundVelocity); // div by 3 to make scorpion legs on platform
+			// createScorpion(registry, renderer, vec2(window_width_px, window_height_px - SCORPION_BB_HEIGHT*2));
 			ice2Spawned++;
 		}
 	}
@@ -828,20 +823,19 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		next_ice_boss_spawn -= elapsed_ms_since_last_update * current_speed;
 		// we are ready for the boss
 		if (next_ice_boss_spawn < 0.f) {
-			iceBoss = createIceBoss(renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2 + 100.0f, GROUND_POSITION - ICE_BOSS_BB_HEIGHT / 2 + 20.0f), foregroundVelocity);
+			iceBoss = createIceBoss(registry, renderer, vec2(playerMotion.position.x + static_cast<float>(window_width_px) / 2 + 100.0f, GROUND_POSITION - ICE_BOSS_BB_HEIGHT / 2 + 20.0f), foregroundVelocity);
 			timeSinceSnowballSpawn = 0;
-			createSnowball(renderer, iceBoss, player_protagonist);
+			createSnowball(registry, renderer, iceBoss, player_protagonist);
 			currentIceBosses++;
-			iceBossAlive = true;
 		}
 
 	}
 
 	// once the boss reaches a third from the right of the screen, stop its movement
 	/*
-	if (forestBossAlive) {
+	if (forestBossesAlive > 0) {
 		Entity entity = registry.forestbosses.entities[0];
-		Motion& boss_motion = registry.motions.get(entity);
+		MotionRef boss_motion = registry.motions.get(entity);
 		 if (boss_motion.position.x <= (window_width_px / 3) * 2) {
 			boss_motion.velocity.x = 0;
 
@@ -860,7 +854,9 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	vec2 rockPosition = { 0, GROUND_POSITION };
 	
 	
-	while (numRocks < 50) {
+	// The missing rocks are placed first and spawned as one batch
+	std::vector<RockPlacement> rocks;
+	while (numRocks < (int)MAX_ROCKS) {
 		//	next_obstacle_spawn = (OBSTACLE_DELAY_MS / 2) + uniform_dist(rng) * (OBSTACLE_DELAY_MS / 2);
 		GEOMETRY_BUFFER_ID rockId;
 		float scaleMultiplier = 1;
@@ -892,35 +888,35 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			rockId = GEOMETRY_BUFFER_ID::ROCK4;
 		}
 
-		Entity rock = createRock(renderer, rockPosition, rockId, scaleMultiplier, foregroundVelocity);
-        registry.colors.insert(rock, currentLevel.rocks_color);
-        //registry.colors.insert(rock, { 1, 0.8f, 0.8f });
+		rocks.push_back({ rockPosition, rockId, scaleMultiplier });
 		numRocks++;
 	}
+	if (!rocks.empty())
+		createRocks(registry, renderer, rocks, foregroundVelocity, currentLevel.rocks_color);
 
 	// Creates the visual bounding boxes in debug mode
 	if (debugging.in_debug_mode) {
 		// Bugs bounding boxes
 		//for (Entity e : registry.eatables.entities) {
-		//	Motion& motion = registry.motions.get(e);
+		//	MotionRef motion = registry.motions.get(e);
 		//	vec2 bounding_box = { abs(motion.scale.x), abs(motion.scale.y) };
 		//	bounding_box /= 2.f;
 
 		//	// Left line
 		//	vec2 leftLinePosition = { motion.position.x - bounding_box.x, motion.position.y };
-		//	createLine(leftLinePosition, { 5, motion.scale.y });
+		//	createLine(registry, leftLinePosition, { 5, motion.scale.y });
 
 		//	// Right line
 		//	vec2 rightLinePosition = { motion.position.x + bounding_box.x, motion.position.y };
-		//	createLine(rightLinePosition, { 5, motion.scale.y });
+		//	createLine(registry, rightLinePosition, { 5, motion.scale.y });
 
 		//	// Top line
 		//	vec2 topLinePosition = { motion.position.x, motion.position.y - bounding_box.y };
-		//	createLine(topLinePosition, { motion.scale.x, 5 });
+		//	createLine(registry, topLinePosition, { motion.scale.x, 5 });
 
 		//	// Bot line
 		//	vec2 botLinePosition = { motion.position.x, motion.position.y + bounding_box.y };
-		//	createLine(botLinePosition, { motion.scale.x, 5 });
+		//	createLine(registry, botLinePosition, { motion.scale.x, 5 });
 
 		//	// Computed direction line if avoiding chicken
 		//	Eatable& eatable = registry.eatables.get(e);
@@ -932,54 +928,54 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		//		else {
 		//			xPosition = motion.position.x + bounding_box.x / 2;
 		//		}
-		//		createLine({ xPosition , motion.position.y }, { motion.scale.x / 2, 5 });
+		//		createLine(registry, { xPosition , motion.position.y }, { motion.scale.x / 2, 5 });
 		//	}
 		//}
 
 		// Items bounding boxes
 		for (Entity e : registry.items.entities) {
-			Motion& motion = registry.motions.get(e);
+			MotionRef motion = registry.motions.get(e);
 			vec2 bounding_box = { abs(motion.scale.x), abs(motion.scale.y) };
 			bounding_box /= 2.f;
 
 			// Left line
 			vec2 leftLinePosition = { motion.position.x - bounding_box.x, motion.position.y };
-			Entity l = createLine(leftLinePosition, { 5, motion.scale.y });
+			Entity l = createLine(registry, leftLinePosition, { 5, motion.scale.y });
 
 			// Right line
 			vec2 rightLinePosition = { motion.position.x + bounding_box.x, motion.position.y };
-			Entity r = createLine(rightLinePosition, { 5, motion.scale.y });
+			Entity r = createLine(registry, rightLinePosition, { 5, motion.scale.y });
 
 			// Top line
 			vec2 topLinePosition = { motion.position.x, motion.position.y - bounding_box.y };
-			Entity t = createLine(topLinePosition, { motion.scale.x, 5 });
+			Entity t = createLine(registry, topLinePosition, { motion.scale.x, 5 });
 
 			// Bot line
 			vec2 botLinePosition = { motion.position.x, motion.position.y + bounding_box.y };
-			Entity b = createLine(botLinePosition, { motion.scale.x, 5 });
+			Entity b = createLine(registry, botLinePosition, { motion.scale.x, 5 });
 		}
 
 		// Deadly bounding boxes
 		for (Entity e : registry.deadlys.entities) {
-			Motion& motion = registry.motions.get(e);
+			MotionRef motion = registry.motions.get(e);
 			vec2 bounding_box = { abs(motion.scale.x), abs(motion.scale.y) };
 			bounding_box /= 2.f;
 
 			// Left line
 			vec2 leftLinePosition = { motion.position.x - bounding_box.x, motion.position.y };
-			Entity l = createLine(leftLinePosition, { 5, motion.scale.y });
+			Entity l = createLine(registry, leftLinePosition, { 5, motion.scale.y });
 
 			// Right line
 			vec2 rightLinePosition = { motion.position.x + bounding_box.x, motion.position.y };
-			Entity r = createLine(rightLinePosition, { 5, motion.scale.y });
+			Entity r = createLine(registry, rightLinePosition, { 5, motion.scale.y });
 
 			// Top line
 			vec2 topLinePosition = { motion.position.x, motion.position.y - bounding_box.y };
-			Entity t = createLine(topLinePosition, { motion.scale.x, 5 });
+			Entity t = createLine(registry, topLinePosition, { motion.scale.x, 5 });
 
 			// Bot line
 			vec2 botLinePosition = { motion.position.x, motion.position.y + bounding_box.y };
-			Entity b = createLine(botLinePosition, { motion.scale.x, 5 });
+			Entity b = createLine(registry, botLinePosition, { motion.scale.x, 5 });
 
 			/*if (registry.bbLightUps.has(e)) {
 				registry.colors.insert(l, { 0, 0, 8 });
@@ -993,9 +989,9 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			//	for (float a = 0; a <= 2 * M_PI; a += M_PI / 6) {
 			//		vec2 position = { cos(a), sin(a) };
 			//		position *= SAFE_DISTANCE;
-			//		Entity rl = createLine(motion.position + position, { 110, 5 });
+			//		Entity rl = createLine(registry, motion.position + position, { 110, 5 });
 
-			//		Motion& rlMotion = registry.motions.get(rl);
+			//		MotionRef rlMotion = registry.motions.get(rl);
 			//		rlMotion.angle = a + M_PI / 2;
 
 			//		registry.colors.insert(rl, { 0, 8, 0 });
@@ -1005,25 +1001,25 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 		// Obstacle bounding boxes
 		for (Entity e : registry.obstacles.entities) {
-			Motion& motion = registry.motions.get(e);
+			MotionRef motion = registry.motions.get(e);
 			vec2 bounding_box = { abs(motion.scale.x), abs(motion.scale.y) };
 			bounding_box /= 2.f;
 
 			// Left line
 			vec2 leftLinePosition = { motion.position.x - bounding_box.x, motion.position.y };
-			Entity l = createLine(leftLinePosition, { 5, motion.scale.y });
+			Entity l = createLine(registry, leftLinePosition, { 5, motion.scale.y });
 
 			// Right line
 			vec2 rightLinePosition = { motion.position.x + bounding_box.x, motion.position.y };
-			Entity r = createLine(rightLinePosition, { 5, motion.scale.y });
+			Entity r = createLine(registry, rightLinePosition, { 5, motion.scale.y });
 
 			// Top line
 			vec2 topLinePosition = { motion.position.x, motion.position.y - bounding_box.y };
-			Entity t = createLine(topLinePosition, { motion.scale.x, 5 });
+			Entity t = createLine(registry, topLinePosition, { motion.scale.x, 5 });
 
 			// Bot line
 			vec2 botLinePosition = { motion.position.x, motion.position.y + bounding_box.y };
-			Entity b = createLine(botLinePosition, { motion.scale.x, 5 });
+			Entity b = createLine(registry, botLinePosition, { motion.scale.x, 5 });
 
 			/*if (registry.bbLightUps.has(e)) {
 				registry.colors.insert(l, { 0, 0, 8 });
@@ -1033,25 +1029,25 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			}*/
 		}
 
-		Motion& motion = registry.motions.get(player_protagonist);
+		MotionRef motion = registry.motions.get(player_protagonist);
 		vec2 bounding_box = { PROTAGONIST_BB_WIDTH, PROTAGONIST_BB_HEIGHT };
 		bounding_box /= 2.f;
 
 		// Left line
 		vec2 leftLinePosition = { motion.position.x - bounding_box.x, motion.position.y };
-		Entity l = createLine(leftLinePosition, { 5, bounding_box.y * 2 });
+		Entity l = createLine(registry, leftLinePosition, { 5, bounding_box.y * 2 });
 
 		// Right line
 		vec2 rightLinePosition = { motion.position.x + bounding_box.x, motion.position.y };
-		Entity r = createLine(rightLinePosition, { 5, bounding_box.y * 2 });
+		Entity r = createLine(registry, rightLinePosition, { 5, bounding_box.y * 2 });
 
 		// Top line
 		vec2 topLinePosition = { motion.position.x, motion.position.y - bounding_box.y };
-		Entity t = createLine(topLinePosition, { bounding_box.x * 2, 5 });
+		Entity t = createLine(registry, topLinePosition, { bounding_box.x * 2, 5 });
 
 		// Bot line
 		vec2 botLinePosition = { motion.position.x, motion.position.y + bounding_box.y };
-		Entity b = createLine(botLinePosition, { bounding_box.x * 2, 5 });
+		Entity b = createLine(registry, botLinePosition, { bounding_box.x * 2, 5 });
 
 		/*if (registry.bbLightUps.has(player)) {
 			registry.colors.insert(l, { 0, 0, 8 });
@@ -1071,29 +1067,34 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	assert(registry.screenStates.components.size() <= 1);
 	ScreenState& screen = registry.screenStates.components[0];
 
+	// Progress the timers on the pool, what happens when one runs out has side effects and stays on this thread
+	float elapsed_ms = elapsed_ms_since_last_update;
+	registry.deathTimers.parallel_for_each(threads, [elapsed_ms](Entity, DeathTimer& counter) { counter.counter_ms -= elapsed_ms; });
+	registry.damageTimers.parallel_for_each(threads, [elapsed_ms](Entity, DamageTimer& counter) { counter.counter_ms -= elapsed_ms; });
+	registry.lightUps.parallel_for_each(threads, [elapsed_ms](Entity, LightUp& light_up) { light_up.counter_ms -= elapsed_ms; });
+
 	float min_counter_ms = 3000.f;
 	for (Entity entity : registry.deathTimers.entities) {
-		// progress timer
 		DeathTimer& counter = registry.deathTimers.get(entity);
-		counter.counter_ms -= elapsed_ms_since_last_update;
 
 		float percentDead = 1 - counter.counter_ms / 3000.f;
         if (registry.colors.has(entity)) {
-            vec3& color = registry.colors.get(entity);
-            color = percentDead * vec3(1.0f, 0.f, 0.f) + (1 - percentDead) * vec3(1.0f, 1.0f, 1.0f);
+            registry.colors.get(entity) = percentDead * vec3(1.0f, 0.f, 0.f) + (1 - percentDead) * vec3(1.0f, 1.0f, 1.0f);
         }
 		if (counter.counter_ms < min_counter_ms && registry.players.has(entity)) {
 			min_counter_ms = counter.counter_ms;
 		}
 
 		// restart the game once the death timer expired
+		// other entities are destroyed through the command buffer, so the loop can go on over the remaining timers
 		if (counter.counter_ms < 0) {
-			registry.deathTimers.remove(entity);
 			if (registry.players.has(entity)) {
+				registry.deathTimers.remove(entity);
 				screen.darken_screen_factor = 0;
                 gameConfig.did_user_fail = true;
                 gameConfig.fail_screen_pause_time = 3000.f;
 				restart_game(LevelType::FOREST_LEVEL, true);
+				return true;
 			}
 			else if (registry.enemies.has(entity)) {
                 
@@ -1104,7 +1105,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
                 unsigned int next_shield_color = clamp((int)health.armor_level, 0, MAX_ARMOR_LEVEL); // clamp((int)health_count, 0, MAX_ARMOR_LEVEL-1);
                 
                 // calculate next sword color to spawn
-                Entity gunEnt = registry.guns.entities[0];
+                Entity gunEnt = registry.gun;
                 assert(registry.guns.has(gunEnt));
                 Gun& gun = registry.guns.get(gunEnt);
                 unsigned int sword_count = floorf(gun.damage / BULLET_DAMAGE);
@@ -1116,43 +1117,40 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
                 if(random <= 50.0f) {
                     if(random_choise < 1.0f) {
                         if(sword_count < MAX_ARMOR_LEVEL) {
-                            createSword(renderer, entity, color_list[next_sword_color]);
+                            createSword(registry, renderer, entity, color_list[next_sword_color]);
                         } else {
                             random_choise = uniform_dist(rng) * 3;
                         }
 
                     } else if(random_choise < 2.0f) {
                         if(health.armor_level < MAX_ARMOR_LEVEL) {
-                            createShield(renderer, entity, color_list[next_shield_color]);
+                            createShield(registry, renderer, entity, color_list[next_shield_color]);
                         } else {
                             random_choise = uniform_dist(rng) * 3;
                         }
                     } else {
                         if(health.health < MAX_PROTAGONIST_HEALTH) {
-                            createHeart(renderer, entity, vec3(1, 1, 1));                    
+                            createHeart(registry, renderer, entity, vec3(1, 1, 1));                    
                         }
                     }
                 }
 
-				registry.remove_all_components_of(entity);
+				registry.commands.destroy(entity);
 
 			}
 			else {
-				registry.remove_all_components_of(entity);
+				registry.commands.destroy(entity);
 			}
-			return true;
 		}
 	}
 
-	// progress damage timer
+	// expire damage timers
 	for (Entity entity : registry.damageTimers.entities) {
-		// progress timer
 		DamageTimer& counter = registry.damageTimers.get(entity);
-		counter.counter_ms -= elapsed_ms_since_last_update;
 
 		// restart the game once the death timer expired
 		if (counter.counter_ms < 0) {
-			registry.damageTimers.remove(entity);
+			registry.commands.remove<DamageTimer>(entity);
 		}
 	}
 
@@ -1163,9 +1161,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	// iterate through all the LightUp entities
 	for (Entity ent : registry.lightUps.entities) {
 		LightUp& light_up = registry.lightUps.get(ent);
-		light_up.counter_ms -= elapsed_ms_since_last_update;
 		if (light_up.counter_ms < 0) {
-			registry.lightUps.remove(ent);
+			registry.commands.remove<LightUp>(ent);
 		}
 	}
 
@@ -1200,7 +1197,66 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	return true;
 }
 
-static Level createForestLevel(RenderSystem* renderer) {
+// Room for everything a level of this type spawns at most, derived from the spawn limits above and what the create functions
+// in world_init.cpp attach. restart_game reserves it so that a full level runs without growing a container.
+static ECSRegistry::CapacityProfile levelCapacity(LevelType level_type) {
+	ECSRegistry::CapacityProfile profile;
+	// The protagonist with its tint and timers, the gun, two backgrounds, two foregrounds and the screen state
+	profile.add<Motion, Mesh*, RenderRequest, Player, Persistent, GroundHeight, Health, vec3, DamageTimer, DeathTimer>(1);
+	profile.add<Motion, Mesh*, RenderRequest, Gun, Parent, Persistent>(1);
+	profile.add<Motion, Mesh*, RenderRequest>(4);
+	profile.add<ScreenState>(1);
+	// The forest level replaces its three help texts after the first kill, the old ones go at the next flush
+	profile.add<Motion, HelpText, DeathTimer>(6);
+	profile.add<Motion, Mesh*, RenderRequest, Obstacle, vec3>(MAX_ROCKS);
+	profile.add<Motion, Mesh*, RenderRequest, Bullet>(MAX_LIVE_BULLETS);
+	profile.add<Motion, RenderRequest, Explosion>(MAX_LIVE_EXPLOSIONS);
+	profile.add<Collision>(MAX_COLLISIONS_PER_STEP);
+
+	size_t enemies = 0;
+	if (level_type == LevelType::FOREST_LEVEL) {
+		profile.add<Motion, Mesh*, RenderRequest, Enemy, Spider, Health, Deadly>(MAX_SPIDERS);
+		profile.add<Motion, Mesh*, RenderRequest, Boss, ForestBoss, Health, Deadly>(MAX_FOREST_BOSSES);
+		profile.add<Motion, RenderRequest, Grenade>(MAX_FOREST_BOSSES);
+		enemies = MAX_SPIDERS + MAX_FOREST_BOSSES;
+	}
+	else if (level_type == LevelType::DESERT_LEVEL) {
+		profile.add<Motion, Mesh*, RenderRequest, Enemy, Scorpion, Health, Deadly>(MAX_SCORPIONS);
+		profile.add<Motion, Mesh*, RenderRequest, Enemy, Snake, Health, Deadly>(MAX_SNAKES);
+		profile.add<Motion, RenderRequest, Boss, DesertBoss, Health, Deadly>(MAX_DESERT_BOSSES);
+		profile.add<Motion, RenderRequest, Tornado>(MAX_DESERT_BOSSES);
+		enemies = MAX_SCORPIONS + MAX_SNAKES + MAX_DESERT_BOSSES;
+	}
+	else if (level_type == LevelType::ICE_LEVEL) {
+		profile.add<Motion, Mesh*, RenderRequest, Enemy, IceMonster1, Health, Deadly>(MAX_ICE_1);
+		profile.add<Motion, Mesh*, RenderRequest, Enemy, IceMonster2, Health, Deadly>(MAX_ICE_2);
+		profile.add<Motion, Mesh*, RenderRequest, Boss, IceBoss, Health, Deadly>(MAX_ICE_BOSSES);
+		profile.add<Motion, RenderRequest, Snowball>(MAX_ICE_BOSSES);
+		enemies = MAX_ICE_1 + MAX_ICE_2 + MAX_ICE_BOSSES;
+	}
+	// A killed enemy turns white until its DeathTimer runs out and drops an item
+	profile.add<DeathTimer, vec3>(enemies);
+	profile.add<Motion, Mesh*, RenderRequest, Item, vec3>(enemies);
+	// A health bar line per enemy, debug mode adds four bounding box lines around the protagonist, every enemy, item and rock
+	profile.add<Motion, RenderRequest, DebugComponent>(enemies + 4 * (1 + 2 * enemies + MAX_ROCKS));
+	return profile;
+}
+
+// Creates the protagonist at 'pos', or moves the one kept from the previous level there when 'player' isn't null
+static Entity placeProtagonist(ECSRegistry& registry, RenderSystem* renderer, Entity player, vec2 pos) {
+	if (player == Entity::null()) {
+		player = createProtagonist(registry, renderer, pos);
+		registry.colors.insert(player, { 1, 0.8f, 0.8f });
+		return player;
+	}
+	MotionRef motion = registry.motions.get(player);
+	motion.position = pos;
+	motion.velocity = { 0.f, 0.f };
+	registry.groundHeights.get(player).y = PROTAGONIST_GROUND_Y;
+	return player;
+}
+
+static Level createForestLevel(ECSRegistry& registry, RenderSystem* renderer, Entity player) {
     
     Level level = {};
     
@@ -1222,24 +1278,23 @@ static Level createForestLevel(RenderSystem* renderer) {
 
     Entity &player_protagonist = level.player_protagonist;
     
-	background_entity = createBackground(renderer, vec2(window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::BACKGROUND2);
-	background_entity2 = createBackground(renderer, vec2(window_width_px + window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT *3/4), TEXTURE_ASSET_ID::BACKGROUND2);
-	foreground_entity = createForeground(renderer, vec2(window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT), TEXTURE_ASSET_ID::FOREST_FOREGROUND);
-	foreground_entity2 = createForeground(renderer, vec2(window_width_px + window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT), TEXTURE_ASSET_ID::FOREST_FOREGROUND);
+	background_entity = createBackground(registry, renderer, vec2(window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::BACKGROUND2);
+	background_entity2 = createBackground(registry, renderer, vec2(window_width_px + window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT *3/4), TEXTURE_ASSET_ID::BACKGROUND2);
+	foreground_entity = createForeground(registry, renderer, vec2(window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT), TEXTURE_ASSET_ID::FOREST_FOREGROUND);
+	foreground_entity2 = createForeground(registry, renderer, vec2(window_width_px + window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT), TEXTURE_ASSET_ID::FOREST_FOREGROUND);
 
-	level.help_text_entity_0 = createHelpText("Use Left and Right arrow keys to move,       ", vec2(window_width_px / 6, window_height_px * 1 / 10), { 0, 0 });
-	level.help_text_entity_1 = createHelpText("                              Up key to jump,", vec2(window_width_px / 6, window_height_px * 2 / 10), { 0, 0 });
-	level.help_text_entity_2 = createHelpText("           And Space to shoot enemies        ", vec2(window_width_px / 6, window_height_px * 3 / 10), { 0, 0 });
+	level.help_text_entity_0 = createHelpText(registry, "Use Left and Right arrow keys to move,       ", vec2(window_width_px / 6, window_height_px * 1 / 10), { 0, 0 });
+	level.help_text_entity_1 = createHelpText(registry, "                              Up key to jump,", vec2(window_width_px / 6, window_height_px * 2 / 10), { 0, 0 });
+	level.help_text_entity_2 = createHelpText(registry, "           And Space to shoot enemies        ", vec2(window_width_px / 6, window_height_px * 3 / 10), { 0, 0 });
 
 	// Create the protagonist
-	vec2 protagonist_init_pos = {window_width_px/2, protagonist_center_pos_y + 50.0f };
-	player_protagonist = createProtagonist(renderer, protagonist_init_pos);
-	registry.colors.insert(player_protagonist, { 1, 0.8f, 0.8f });
+	vec2 protagonist_init_pos = {window_width_px/2, PROTAGONIST_GROUND_Y + 50.0f };
+	player_protagonist = placeProtagonist(registry, renderer, player, protagonist_init_pos);
 
     return level;
 }
 
-static Level createDesertLevel(RenderSystem* renderer) {
+static Level createDesertLevel(ECSRegistry& registry, RenderSystem* renderer, Entity player) {
 
     Level level = {};
 
@@ -1262,20 +1317,19 @@ static Level createDesertLevel(RenderSystem* renderer) {
 
     Entity &player_protagonist = level.player_protagonist;
     
-	background_entity = createBackground(renderer, vec2(window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::BACKGROUND);
-	background_entity2 = createBackground(renderer, vec2(window_width_px + window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT *3/4), TEXTURE_ASSET_ID::BACKGROUND);
-	foreground_entity = createForeground(renderer, vec2(window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT), TEXTURE_ASSET_ID::FOREGROUND);
-	foreground_entity2 = createForeground2(renderer, vec2(window_width_px + window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT));
+	background_entity = createBackground(registry, renderer, vec2(window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::BACKGROUND);
+	background_entity2 = createBackground(registry, renderer, vec2(window_width_px + window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT *3/4), TEXTURE_ASSET_ID::BACKGROUND);
+	foreground_entity = createForeground(registry, renderer, vec2(window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT), TEXTURE_ASSET_ID::FOREGROUND);
+	foreground_entity2 = createForeground2(registry, renderer, vec2(window_width_px + window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT));
 
 	// Create the protagonist
-	vec2 protagonist_init_pos = {window_width_px/2, protagonist_center_pos_y };
-	player_protagonist = createProtagonist(renderer, protagonist_init_pos);
-	registry.colors.insert(player_protagonist, { 1, 0.8f, 0.8f });
+	vec2 protagonist_init_pos = {window_width_px/2, PROTAGONIST_GROUND_Y };
+	player_protagonist = placeProtagonist(registry, renderer, player, protagonist_init_pos);
     
     return level;
 }
 
-static Level createIceLevel(RenderSystem* renderer) {
+static Level createIceLevel(ECSRegistry& registry, RenderSystem* renderer, Entity player) {
 
 	Level level = {};
 
@@ -1299,15 +1353,14 @@ static Level createIceLevel(RenderSystem* renderer) {
 
 	Entity& player_protagonist = level.player_protagonist;
 
-	background_entity = createBackground(renderer, vec2(window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::ICE_BACKGROUND);
-	background_entity2 = createBackground(renderer, vec2(window_width_px + window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::ICE_BACKGROUND);
-	foreground_entity = createForeground(renderer, vec2(window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT + 15.0f), TEXTURE_ASSET_ID::ICE_FOREGROUND);
-	foreground_entity2 = createForeground(renderer, vec2(window_width_px + window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT + 15.0f), TEXTURE_ASSET_ID::ICE_FOREGROUND);
+	background_entity = createBackground(registry, renderer, vec2(window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::ICE_BACKGROUND);
+	background_entity2 = createBackground(registry, renderer, vec2(window_width_px + window_width_px / 2, window_height_px / 2 - PLATFORM_HEIGHT * 3 / 4), TEXTURE_ASSET_ID::ICE_BACKGROUND);
+	foreground_entity = createForeground(registry, renderer, vec2(window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT + 15.0f), TEXTURE_ASSET_ID::ICE_FOREGROUND);
+	foreground_entity2 = createForeground(registry, renderer, vec2(window_width_px + window_width_px / 2, PLATFORM_CENTER), vec2(window_width_px, PLATFORM_HEIGHT + 15.0f), TEXTURE_ASSET_ID::ICE_FOREGROUND);
 
 	// Create the protagonist
-	vec2 protagonist_init_pos = { window_width_px / 2, protagonist_center_pos_y };
-	player_protagonist = createProtagonist(renderer, protagonist_init_pos);
-	registry.colors.insert(player_protagonist, { 1, 0.8f, 0.8f });
+	vec2 protagonist_init_pos = { window_width_px / 2, PROTAGONIST_GROUND_Y };
+	player_protagonist = placeProtagonist(registry, renderer, player, protagonist_init_pos);
 
 	return level;
 }
@@ -1316,32 +1369,41 @@ static Level createIceLevel(RenderSystem* renderer) {
 void WorldSystem::restart_game(LevelType level_type, bool reset_stats) {
 	// Debugging for memory/component leaks
 	registry.list_all_components();
+
+	// Make room for the whole level up front, the containers report if it spawns more
+	registry.reserve(levelCapacity(level_type));
 	printf("Restarting\n");
 
 	// Reset the game speed
 	current_speed = 1.f;
     
-    Health saved_player_health;
-    Gun saved_player_gun;
-    if(!reset_stats) {
-        saved_player_health = registry.healths.get(currentLevel.player_protagonist);
-        Entity gunEnt = registry.guns.entities[0];
-        assert(registry.guns.has(gunEnt));
-        saved_player_gun = registry.guns.get(gunEnt);
-    }
+	// Moving on to the next biome keeps the protagonist and the gun with their health and damage
+	Entity kept_player = Entity::null();
+	if (!reset_stats) {
+		kept_player = currentLevel.player_protagonist;
+		assert(registry.persistents.has(kept_player) && registry.persistents.has(registry.gun));
+	}
+
+	// Changes recorded for the old level don't apply to the new one
+	registry.commands.clear();
 
-    
 	// Remove all entities that we created
-	// All that have a motion, we could also iterate over all bug, eagles, ... but that would be more cumbersome
-	while (registry.motions.entities.size() > 0)
-		registry.remove_all_components_of(registry.motions.entities.back());
+	// All that have a motion, we could also iterate over all bug, eagles, ... but that would be more cumbersome.
+	// A transition leaves the persistent ones, the whole level goes in one pass over the containers either way.
+	if (reset_stats)
+		registry.destroy(registry.motions.entities);
+	else
+		registry.destroy_if([this](Entity e) { return registry.motions.has(e) && !registry.persistents.has(e); });
+
+	// Nothing of the old level points into its arena anymore
+	registry.level_arena.release();
 
 	// Debugging for memory/component leaks
 	registry.list_all_components();
 
     // Setup game levels
     if(level_type == LevelType::DESERT_LEVEL) {
-        currentLevel = createDesertLevel(renderer);
+        currentLevel = createDesertLevel(registry, renderer, kept_player);
         desertBossesKilled = 0;
         scorpionsKilled = 0;
         snakesKilled = 0;
@@ -1349,13 +1411,11 @@ void WorldSystem::restart_game(LevelType level_type, bool reset_stats) {
         scorpionsSpawned = 0;
         snakesSpawned = 0;
         timeSinceTornadoSpawn = 0;
-        desertBossKilled = false;
-        desertBossAlive = false;
     } else if(level_type == LevelType::FOREST_LEVEL) {
-        currentLevel = createForestLevel(renderer);
+        currentLevel = createForestLevel(registry, renderer, kept_player);
 	}
 	else if (level_type == LevelType::ICE_LEVEL) {
-		currentLevel = createIceLevel(renderer);
+		currentLevel = createIceLevel(registry, renderer, kept_player);
 	} else {
         assert(!"invalid level type!");
     }
@@ -1364,9 +1424,6 @@ void WorldSystem::restart_game(LevelType level_type, bool reset_stats) {
     // Setup transition initial state
     on_level_transition_timer = 0;
 
-	chickenFalling = false;
-	keyPressed = false;
-
 	scorpionsKilled = 0;
     snakesKilled = 0;
     spiderKilled = 0;
@@ -1388,30 +1445,21 @@ void WorldSystem::restart_game(LevelType level_type, bool reset_stats) {
     timeSinceGrenadeSpawn = 0;
     timeSinceTornadoSpawn = 0;
 	timeSinceSnowballSpawn = 0;
-	forestbossKilled = false;
-	forestBossAlive = false;
-    desertBossKilled = false;
-    desertBossAlive = false;
-	iceBossKilled = false;
-	iceBossAlive = false;
 
 
-	createGun(renderer);
-    
-    if(!reset_stats) {
-        Health& playerHealth = registry.healths.get(currentLevel.player_protagonist);
-        playerHealth = saved_player_health;
-        Entity gunEnt = registry.guns.entities[0];
-        assert(registry.guns.has(gunEnt));
-        Gun& gun = registry.guns.get(gunEnt);
-        gun = saved_player_gun;
-    }
-
+	if (kept_player == Entity::null()) {
+		createGun(registry, renderer);
+	}
+	else {
+		// The kept entities are at the front of the draw order, behind the new backgrounds
+		registry.renderables.move_to_back(kept_player);
+		registry.renderables.move_to_back(registry.gun);
+	}
 }
 
-void handle_player_enemy_weapon_collisions(Entity entity, Entity weapon) {
-	if ((registry.players.has(entity) || registry.enemies.has(entity)) && (registry.healths.has(entity))) {
-		Health& entityHealth = registry.healths.get(entity);
+void handle_player_enemy_weapon_collisions(ECSRegistry& registry, Entity entity, Entity weapon) {
+	if (registry.has_any(entity, registry.mask<Player, Enemy>()) && registry.has_all(entity, registry.mask<Health>())) {
+		Health& entityHealth = registry.healths.patch(entity);
 		if (registry.swords.has(weapon)) {
 			entityHealth.health -= SWORD_DAMAGE;
 		}
@@ -1423,13 +1471,13 @@ void handle_player_enemy_weapon_collisions(Entity entity, Entity weapon) {
 				registry.deathTimers.emplace(entity);
 			}
 			else if (registry.enemies.has(entity)) {
-				registry.remove_all_components_of(entity);
+				registry.commands.destroy(entity);
 			}
 		}
 	}
 }
 
-void handle_player_item_collisions(Entity playerEnt, Entity itemEnt) {
+void handle_player_item_collisions(ECSRegistry& registry, Entity playerEnt, Entity itemEnt) {
 
 	Player player = registry.players.get(playerEnt);
 	Item item = registry.items.get(itemEnt);
@@ -1437,10 +1485,10 @@ void handle_player_item_collisions(Entity playerEnt, Entity itemEnt) {
     switch(item.type) {
         case Item::TYPE_ID::SWORD: {
             // Get gun entity
-            Entity gunEnt = registry.guns.entities[0];
+            Entity gunEnt = registry.gun;
             // Some sanity check
             assert(registry.guns.has(gunEnt));
-            Gun& gun = registry.guns.get(gunEnt);
+            Gun& gun = registry.guns.patch(gunEnt);
             // Increase gun damage
             gun.damage += BULLET_DAMAGE;
         } break;
@@ -1448,7 +1496,7 @@ void handle_player_item_collisions(Entity playerEnt, Entity itemEnt) {
             // Some sanity check
             assert(registry.healths.has(playerEnt));
 
-            Health& health = registry.healths.get(playerEnt);
+            Health& health = registry.healths.patch(playerEnt);
 
             if(health.armor_level < MAX_ARMOR_LEVEL) {
                 health.armor_level += 1;
@@ -1458,7 +1506,7 @@ void handle_player_item_collisions(Entity playerEnt, Entity itemEnt) {
             // Some sanity check
             assert(registry.healths.has(playerEnt));
 
-            Health& health = registry.healths.get(playerEnt);
+            Health& health = registry.healths.patch(playerEnt);
 
             // Round up the current player heath
             health.health = health.health - fmodf(health.health+PROTAGONIST_HEALTH, PROTAGONIST_HEALTH);
@@ -1471,6 +1519,20 @@ void handle_player_item_collisions(Entity playerEnt, Entity itemEnt) {
 
 // Compute collisions between entities
 void WorldSystem::handle_collisions() {
+	// The component signatures the collision pairs are tested against, see BasicRegistry::mask()
+	constexpr ComponentMask grenade_mask = ECSRegistry::mask<Grenade>();
+	constexpr ComponentMask snowball_mask = ECSRegistry::mask<Snowball>();
+	constexpr ComponentMask tornado_mask = ECSRegistry::mask<Tornado>();
+	constexpr ComponentMask bullet_mask = ECSRegistry::mask<Bullet>();
+	constexpr ComponentMask player_mask = ECSRegistry::mask<Player>();
+	constexpr ComponentMask enemy_mask = ECSRegistry::mask<Enemy>();
+	constexpr ComponentMask obstacle_mask = ECSRegistry::mask<Obstacle>();
+	constexpr ComponentMask player_or_obstacle_mask = ECSRegistry::mask<Player, Obstacle>();
+	constexpr ComponentMask boss_breaking_rocks_mask = ECSRegistry::mask<ForestBoss, IceBoss>();
+	constexpr ComponentMask deadly_mask = ECSRegistry::mask<Deadly>();
+	constexpr ComponentMask item_mask = ECSRegistry::mask<Item>();
+	constexpr ComponentMask timers_mask = ECSRegistry::mask<DeathTimer, DamageTimer>();
+
 	// Loop over all collisions detected by the physics system
 	auto& collisionsRegistry = registry.collisions;
 	for (uint i = 0; i < collisionsRegistry.components.size(); i++) {
@@ -1478,81 +1540,82 @@ void WorldSystem::handle_collisions() {
 		Entity entity = collisionsRegistry.entities[i];
 		Entity entity_other = collisionsRegistry.components[i].other;
 
+		// Entities are destroyed through the command buffer so that the collisions don't get reshuffled under this loop,
+		// skip the pairs of those already handled
+		if (registry.commands.is_pending_destroy(entity) || registry.commands.is_pending_destroy(entity_other))
+			continue;
 
 		// Handle collisions between player/enemy and weapons
-		// handle_player_enemy_weapon_collisions(entity, entity_other);
+		// handle_player_enemy_weapon_collisions(registry, entity, entity_other);
 
-        if (registry.grenades.has(entity) &&
-            (registry.players.has(entity_other) || registry.obstacles.has(entity_other))) {
+        if (registry.has_all(entity, grenade_mask) && registry.has_any(entity_other, player_or_obstacle_mask)) {
             Grenade grenade = registry.grenades.get(entity);
             Motion grenadeMotion = registry.motions.get(entity);
             if (!registry.deathTimers.has(entity_other) && registry.players.has(entity_other)) {
-                Health& playerHealth = registry.healths.get(entity_other);
+                Health& playerHealth = registry.healths.patch(entity_other);
                 playerHealth.health -= (int) grenade.damage / playerHealth.armor_level;
 
                 if (playerHealth.health <= 0) {
                     Mix_PlayChannel(-1, game_over_sound, 0);
                     registry.deathTimers.emplace(entity_other);
                     registry.colors.emplace_with_duplicates(entity_other, vec3(1.0f, 1.0f, 1.0f));
-                    for (auto& motion : registry.motions.components) {
+                    for (MotionRef motion : registry.motions.components) {
                         motion.velocity.x = 0.f;
                     }
                 }
             }
             timeSinceExplosionSwitch = 0;
             Mix_PlayChannel(-1, explosion_sound, 0);
-            createExplosion(renderer, grenadeMotion.position);
-            registry.remove_all_components_of(entity);
+            createExplosion(registry, renderer, grenadeMotion.position);
+            registry.commands.destroy(entity);
         }
 
 
-		if (registry.snowballs.has(entity) &&
-			(registry.players.has(entity_other) || registry.obstacles.has(entity_other))) {
+		if (registry.has_all(entity, snowball_mask) && registry.has_any(entity_other, player_or_obstacle_mask)) {
 			Snowball snowball = registry.snowballs.get(entity);
 			Motion snowballMotion = registry.motions.get(entity);
 			if (!registry.deathTimers.has(entity_other) && registry.players.has(entity_other)) {
-				Health& playerHealth = registry.healths.get(entity_other);
+				Health& playerHealth = registry.healths.patch(entity_other);
 				playerHealth.health -= (int)snowball.damage / playerHealth.armor_level;
 
 				if (playerHealth.health <= 0) {
 					Mix_PlayChannel(-1, game_over_sound, 0);
 					registry.deathTimers.emplace(entity_other);
 					registry.colors.emplace_with_duplicates(entity_other, vec3(1.0f, 1.0f, 1.0f));
-					for (auto& motion : registry.motions.components) {
+					for (MotionRef motion : registry.motions.components) {
 						motion.velocity.x = 0.f;
 					}
 				}
 			}
-			registry.remove_all_components_of(entity);
+			registry.commands.destroy(entity);
 		}
 
 
-        if (registry.tornados.has(entity) &&
-            (registry.players.has(entity_other) || registry.obstacles.has(entity_other))) {
+        if (registry.has_all(entity, tornado_mask) && registry.has_any(entity_other, player_or_obstacle_mask)) {
             Tornado tornado = registry.tornados.get(entity);
             Motion tornadoMotion = registry.motions.get(entity);
             if (!registry.deathTimers.has(entity_other) && registry.players.has(entity_other)) {
-                Health& playerHealth = registry.healths.get(entity_other);
+                Health& playerHealth = registry.healths.patch(entity_other);
                 playerHealth.health -= (int) tornado.damage / playerHealth.armor_level;
 
                 if (playerHealth.health <= 0) {
                     Mix_PlayChannel(-1, game_over_sound, 0);
                     registry.deathTimers.emplace(entity_other);
                     registry.colors.emplace_with_duplicates(entity_other, vec3(1.0f, 1.0f, 1.0f));
-                    for (auto& motion : registry.motions.components) {
+                    for (MotionRef motion : registry.motions.components) {
                         motion.velocity.x = 0.f;
                     }
                 }
             }
-            registry.remove_all_components_of(entity);
+            registry.commands.destroy(entity);
         }
 
 
-		if (registry.obstacles.has(entity_other) && registry.enemies.has(entity)) {
+		if (registry.has_all(entity_other, obstacle_mask) && registry.has_all(entity, enemy_mask)) {
 
 			if (!registry.deathTimers.has(entity)) {
-				Motion& deadlyMotion = registry.motions.get(entity);
-				Motion& rockMotion = registry.motions.get(entity_other);
+				MotionRef deadlyMotion = registry.motions.get(entity);
+				MotionRef rockMotion = registry.motions.get(entity_other);
 
 				if (deadlyMotion.position.x - rockMotion.position.x < 0) {
 					// hits left side of rock
@@ -1579,48 +1642,41 @@ void WorldSystem::handle_collisions() {
 			}
 		}
 
-		if (registry.obstacles.has(entity_other) && registry.forestBosses.has(entity)) {
-			// boss destroys rock
-			registry.remove_all_components_of(entity_other);
-
-		}
-
-		if (registry.obstacles.has(entity_other) && registry.iceBosses.has(entity)) {
+		if (registry.has_all(entity_other, obstacle_mask) && registry.has_any(entity, boss_breaking_rocks_mask)) {
 			// boss destroys rock
-			registry.remove_all_components_of(entity_other);
+			registry.commands.destroy(entity_other);
 
 		}
 
-		if (registry.bullets.has(entity) && registry.obstacles.has(entity_other)) {
+		if (registry.has_all(entity, bullet_mask) && registry.has_all(entity_other, obstacle_mask)) {
 			// rock destroys bullet
-			registry.remove_all_components_of(entity);
+			registry.commands.destroy(entity);
 		}
 
-        if (registry.bullets.has(entity) && registry.deadlys.has(entity_other)) {
-            if (!registry.deathTimers.has(entity_other)) {
+        if (registry.has_all(entity, bullet_mask) && registry.has_all(entity_other, deadly_mask)) {
+            // A boss killed by an earlier bullet is dying or already on its way out
+            if (!registry.deathTimers.has(entity_other) && !registry.commands.is_pending_destroy(entity_other)) {
                 /*
                 registry.deathTimers.emplace(entity_other);
                 registry.colors.emplace_with_duplicates(entity_other, vec3(1.0f, 1.0f, 1.0f));
                 */
-                Motion &deadlyMotion = registry.motions.get(entity_other);
+                MotionRef deadlyMotion = registry.motions.get(entity_other);
                 /*
                 deadlyMotion.velocity = vec2({0.0f, 0.0f});
-                registry.remove_all_components_of(entity);
+                registry.commands.destroy(entity);
                 if (registry.enemies.has(entity_other)) {
                     scorpionsKilled++;
                 }
                 */
-                registry.remove_all_components_of(entity);
-                Entity gun = registry.guns.entities[0];
+                registry.commands.destroy(entity);
+                Entity gun = registry.gun;
                 Gun& gunComponent = registry.guns.get(gun);
 
-                if (forestBossAlive && registry.forestBosses.has(entity_other)) {
-                    Health &bossHealth = registry.healths.get(entity_other);
+                if (registry.forestBosses.has(entity_other)) {
+                    Health &bossHealth = registry.healths.patch(entity_other);
                     bossHealth.health -= gunComponent.damage;
                     if (bossHealth.health <= 0) {
                         forestBossesKilled++;
-                        forestBossAlive = false;
-                        forestbossKilled = true;
 
                         if(currentLevel.forest_boss_enable) {
                             Mix_PlayChannel(-1, player_win_sound, 0);
@@ -1631,13 +1687,11 @@ void WorldSystem::handle_collisions() {
                         continue;
                     }
                 }
-                if (desertBossAlive && registry.desertBosses.has(entity_other)) {
-                    Health &bossHealth = registry.healths.get(entity_other);
+                if (registry.desertBosses.has(entity_other)) {
+                    Health &bossHealth = registry.healths.patch(entity_other);
                     bossHealth.health -= gunComponent.damage;
                     if (bossHealth.health <= 0) {
                         desertBossesKilled++;
-                        desertBossAlive = false;
-                        desertBossKilled = true;
 
 						if (currentLevel.boss_spawn_enable) {
 							Mix_PlayChannel(-1, player_win_sound, 0);
@@ -1648,20 +1702,18 @@ void WorldSystem::handle_collisions() {
                         continue;
                     }
                 }
-				if (iceBossAlive && registry.iceBosses.has(entity_other)) {
-					Health& bossHealth = registry.healths.get(entity_other);
+				if (registry.iceBosses.has(entity_other)) {
+					Health& bossHealth = registry.healths.patch(entity_other);
 					bossHealth.health -= gunComponent.damage;
 					if (bossHealth.health <= 0) {
 						iceBossesKilled++;
-						iceBossAlive = false;
-						iceBossKilled = true;
 					}
 					else {
 						continue;
 					}
 				}
                 if (registry.scorpions.has(entity_other)) {
-                    Health &scorpionHealth = registry.healths.get(entity_other);
+                    Health &scorpionHealth = registry.healths.patch(entity_other);
                     scorpionHealth.health -= gunComponent.damage;;
                     if (scorpionHealth.health <= 0) {
                         scorpionsKilled++;
@@ -1670,7 +1722,7 @@ void WorldSystem::handle_collisions() {
                     }
                 }
                 if (registry.snakes.has(entity_other)) {
-                    Health &snakeHealth = registry.healths.get(entity_other);
+                    Health &snakeHealth = registry.healths.patch(entity_other);
                     snakeHealth.health -= gunComponent.damage;;
                     if (snakeHealth.health <= 0) {
                         snakesKilled++;
@@ -1679,18 +1731,18 @@ void WorldSystem::handle_collisions() {
                     }
                 }
                 if (registry.spiders.has(entity_other)) {
-                    Health &spiderHealth = registry.healths.get(entity_other);
+                    Health &spiderHealth = registry.healths.patch(entity_other);
                     spiderHealth.health -= gunComponent.damage;
                     if (spiderHealth.health <= 0) {
                         spiderKilled++;
 						if (spiderKilled == 1 && currentLevel.type == LevelType::FOREST_LEVEL) {
-							registry.remove_all_components_of(currentLevel.help_text_entity_0);
-							registry.remove_all_components_of(currentLevel.help_text_entity_1);
-							registry.remove_all_components_of(currentLevel.help_text_entity_2);
+							registry.commands.destroy(currentLevel.help_text_entity_0);
+							registry.commands.destroy(currentLevel.help_text_entity_1);
+							registry.commands.destroy(currentLevel.help_text_entity_2);
 
-							currentLevel.help_text_entity_0 = createHelpText("Dead enemies can drop damage boosts, armour, and hearts                ", vec2(window_width_px / 90, window_height_px * 1 / 10), { 0, 0 });
-							currentLevel.help_text_entity_1 = createHelpText("           Kill the enemies and bosses of all 3 levels to win          ", vec2(window_width_px / 90, window_height_px * 2 / 10), { 0, 0 });
-							currentLevel.help_text_entity_2 = createHelpText("                                           Press H for Help. Good Luck!", vec2(window_width_px / 90, window_height_px * 3 / 10), { 0, 0 });
+							currentLevel.help_text_entity_0 = createHelpText(registry, "Dead enemies can drop damage boosts, armour, and hearts                ", vec2(window_width_px / 90, window_height_px * 1 / 10), { 0, 0 });
+							currentLevel.help_text_entity_1 = createHelpText(registry, "           Kill the enemies and bosses of all 3 levels to win          ", vec2(window_width_px / 90, window_height_px * 2 / 10), { 0, 0 });
+							currentLevel.help_text_entity_2 = createHelpText(registry, "                                           Press H for Help. Good Luck!", vec2(window_width_px / 90, window_height_px * 3 / 10), { 0, 0 });
 
 							DeathTimer& d0 = registry.deathTimers.emplace(currentLevel.help_text_entity_0);
 							d0.counter_ms = 20000;
@@ -1704,7 +1756,7 @@ void WorldSystem::handle_collisions() {
                     }
                 }
 				if (registry.ice1Monsters.has(entity_other)) {
-					Health& ice1Health = registry.healths.get(entity_other);
+					Health& ice1Health = registry.healths.patch(entity_other);
 					ice1Health.health -= gunComponent.damage;;
 					if (ice1Health.health <= 0) {
 						iceMonster1Killed++;
@@ -1714,7 +1766,7 @@ void WorldSystem::handle_collisions() {
 					}
 				}
 				if (registry.ice2Monsters.has(entity_other)) {
-					Health& ice2Health = registry.healths.get(entity_other);
+					Health& ice2Health = registry.healths.patch(entity_other);
 					ice2Health.health -= gunComponent.damage;;
 					if (ice2Health.health <= 0) {
 						iceMonster2Killed++;
@@ -1734,18 +1786,18 @@ void WorldSystem::handle_collisions() {
         }
 
 
-		if (registry.players.has(entity)) {
+		if (registry.has_all(entity, player_mask)) {
 			// Checking Player - Scorpion collisions
-			if (registry.items.has(entity_other)) {
+			if (registry.has_all(entity_other, item_mask)) {
 				// Cheking Player - Item collisions
-				handle_player_item_collisions(entity, entity_other);
+				handle_player_item_collisions(registry, entity, entity_other);
 				// Remove item entity
-				registry.remove_all_components_of(entity_other);
+				registry.commands.destroy(entity_other);
 
 			}
-			else if (registry.deadlys.has(entity_other)) {
-				Motion& playerMotion = registry.motions.get(entity);
-				Motion& otherMotion = registry.motions.get(entity_other);
+			else if (registry.has_all(entity_other, deadly_mask)) {
+				MotionRef playerMotion = registry.motions.get(entity);
+				MotionRef otherMotion = registry.motions.get(entity_other);
 				const vec2 player_bounding_box = { PROTAGONIST_BB_WIDTH / 2.f, PROTAGONIST_BB_HEIGHT / 2.f };
 				const vec2 other_bounding_box = { abs(otherMotion.scale.x) / 2.f, abs(otherMotion.scale.y) / 2.f };
 
@@ -1761,17 +1813,17 @@ void WorldSystem::handle_collisions() {
 
 				if (motion1Top < motion2Bottom && motion2Top < motion1Bottom && motion1Left < motion2Right && motion2Left < motion1Right) {
 
-					if (!registry.deathTimers.has(entity) && !registry.damageTimers.has(entity)) {
+					if (!registry.has_any(entity, timers_mask)) {
 						assert(registry.healths.has(entity));
-						Health& playerHealth = registry.healths.get(entity);
+						Health& playerHealth = registry.healths.patch(entity);
 						
                         // Dependes the level we are in the damage we take
                         if(currentLevel.type == LevelType::FOREST_LEVEL) {
-                            playerHealth.health -= forestBossAlive ? (FOREST_BOSS_DAMAGE / playerHealth.armor_level) : (BUG_DAMAGE / playerHealth.armor_level);
+                            playerHealth.health -= forestBossesAlive > 0 ? (FOREST_BOSS_DAMAGE / playerHealth.armor_level) : (BUG_DAMAGE / playerHealth.armor_level);
                         } else if(currentLevel.type == LevelType::DESERT_LEVEL) {
-                                playerHealth.health -= desertBossAlive ? (DESERT_BOSS_DAMAGE / playerHealth.armor_level) : (SCORPION_DAMAGE / playerHealth.armor_level);
+                                playerHealth.health -= desertBossesAlive > 0 ? (DESERT_BOSS_DAMAGE / playerHealth.armor_level) : (SCORPION_DAMAGE / playerHealth.armor_level);
                         } else if (currentLevel.type == LevelType::ICE_LEVEL) {
-							playerHealth.health -= iceBossAlive ? (ICE_BOSS_DAMAGE / playerHealth.armor_level) : (ICE1_DAMAGE / playerHealth.armor_level);
+							playerHealth.health -= iceBossesAlive > 0 ? (ICE_BOSS_DAMAGE / playerHealth.armor_level) : (ICE1_DAMAGE / playerHealth.armor_level);
 						} else {
                             assert(!"invalid level!");
                         }
@@ -1783,23 +1835,23 @@ void WorldSystem::handle_collisions() {
 							Mix_PlayChannel(-1, game_over_sound, 0);
 							registry.deathTimers.emplace(entity);
 							registry.colors.emplace_with_duplicates(entity, vec3(1.0f, 1.0f, 1.0f));
-							for (auto& motion : registry.motions.components) {
+							for (MotionRef motion : registry.motions.components) {
 								motion.velocity.x = 0.f;
 							}
 						}
 					}
 				}
 			}
-			else if (registry.obstacles.has(entity_other)) {
+			else if (registry.has_all(entity_other, obstacle_mask)) {
 				// printf("bb collision with obstacle\n");
 
-				Motion& playerMotion = registry.motions.get(entity);
+				MotionRef playerMotion = registry.motions.get(entity);
 				float playerLeft = playerMotion.position.x - PROTAGONIST_BB_WIDTH / 2;
 				float playerRight = playerMotion.position.x + PROTAGONIST_BB_WIDTH / 2;
 				float playerTop = playerMotion.position.y - PROTAGONIST_BB_HEIGHT / 2;
 				float playerBottom = playerMotion.position.y + PROTAGONIST_BB_HEIGHT / 2;
 				Mesh* mesh = registry.meshPtrs.get(entity_other);
-				Motion& obstacleMotion = registry.motions.get(entity_other);
+				MotionRef obstacleMotion = registry.motions.get(entity_other);
 				bool isCollision = false;
 				/*float angleRad = -playerMotion.angle;
 				glm::mat2 rotationMatrix = glm::mat2(cos(angleRad), -sin(angleRad), sin(angleRad), cos(angleRad));*/
@@ -1826,9 +1878,9 @@ void WorldSystem::handle_collisions() {
                     Entity foreground_entity2 = currentLevel.foreground_entity2;
                     Entity player_protagonist = currentLevel.player_protagonist;
 
-					Motion& background_motion = registry.motions.get(background_entity);
+					MotionRef background_motion = registry.motions.get(background_entity);
 					background_motion.velocity.x = 0;
-					Motion& background_motion2 = registry.motions.get(background_entity2);
+					MotionRef background_motion2 = registry.motions.get(background_entity2);
 					background_motion2.velocity.x = 0;
 
 					playerMoving = false;
@@ -1836,7 +1888,7 @@ void WorldSystem::handle_collisions() {
 					float obstacleLeft = obstacleMotion.position.x - abs(obstacleMotion.scale.x) / 2;
 					float obstacleRight = obstacleMotion.position.x + abs(obstacleMotion.scale.x) / 2;
 					if (playerMotion.position.x < obstacleLeft) {
-						for (auto& motion : registry.motions.components) {
+						for (MotionRef motion : registry.motions.components) {
 							motion.position.x += 1;
 						}
 
@@ -1845,17 +1897,17 @@ void WorldSystem::handle_collisions() {
 						float positionDiff = playerMotion.position.x - oldPlayerXPosition;
 
 						// deal with background (parallaxing)
-						Motion& background_motion = registry.motions.get(background_entity);
+						MotionRef background_motion = registry.motions.get(background_entity);
 						background_motion.position.x += positionDiff / 2;
-						Motion& background_motion2 = registry.motions.get(background_entity2);
+						MotionRef background_motion2 = registry.motions.get(background_entity2);
 						background_motion2.position.x += positionDiff / 2;
 					}
 					else if (playerMotion.position.x >= obstacleLeft && playerMotion.position.x < obstacleRight) {
 						playerMotion.position.y -= 1;
-						protagonist_center_pos_y = playerMotion.position.y;
+						registry.groundHeights.get(player_protagonist).y = playerMotion.position.y;
 					}
 					else {
-						for (auto& motion : registry.motions.components) {
+						for (MotionRef motion : registry.motions.components) {
 							motion.position.x -= 1;
 						}
 
@@ -1864,9 +1916,9 @@ void WorldSystem::handle_collisions() {
 						float positionDiff = playerMotion.position.x - oldPlayerXPosition;
 
 						// deal with background (parallaxing)
-						Motion& background_motion = registry.motions.get(background_entity);
+						MotionRef background_motion = registry.motions.get(background_entity);
 						background_motion.position.x += positionDiff / 2;
-						Motion& background_motion2 = registry.motions.get(background_entity2);
+						MotionRef background_motion2 = registry.motions.get(background_entity2);
 						background_motion2.position.x += positionDiff / 2;
 					}
 				}
@@ -1886,11 +1938,11 @@ bool WorldSystem::is_over() const {
 /*
 void move_protagonist(int key, int action, Entity protagonist) {
 	auto& motionRegistry = registry.motions;
-	Motion& protagonistMotion = motionRegistry.get(protagonist);
+	MotionRef protagonistMotion = motionRegistry.get(protagonist);
 	if (!registry.deathTimers.has(protagonist)) {
 		if (action == GLFW_PRESS && key == GLFW_KEY_UP) {
 			// May want to replace ground position with colliding with walkable entities
-			if (protagonistMotion.position.y == protagonist_center_pos_y) {
+			if (protagonistMotion.position.y == registry.groundHeights.get(protagonist).y) {
 				protagonistMotion.velocity.x = 0.f;
 				protagonistMotion.velocity.y = -100.f;
 			}
@@ -1941,7 +1993,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	if (!registry.deathTimers.has(player_protagonist)) {
 		if (action == GLFW_PRESS && key == GLFW_KEY_UP) {
 			// protagonist should jump
-			Motion& protagonist_motion = motionRegistry.get(player_protagonist);
+			MotionRef protagonist_motion = motionRegistry.get(player_protagonist);
 			protagonist_motion.velocity.y = -300.f;
 			Mix_PlayChannel(-1, player_jump_sound, 0);
 		}
@@ -1950,50 +2002,50 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 		}
 		else if ((action == GLFW_PRESS || action == GLFW_REPEAT) && key == GLFW_KEY_LEFT) {
 			// DEAL WITH PROTAGONIST
-			Motion& protagonist_motion = motionRegistry.get(player_protagonist);
+			MotionRef protagonist_motion = motionRegistry.get(player_protagonist);
 			protagonist_motion.scale.x = -abs(protagonist_motion.scale.x);
 			protagonist_motion.velocity.x = -200.0f; // temporary until we implement a bounding box for character movement
 			// deal with background (parallaxing)
-			Motion& background_motion = motionRegistry.get(background_entity);
+			MotionRef background_motion = motionRegistry.get(background_entity);
 			background_motion.velocity.x = -100;
-			Motion& background_motion2 = motionRegistry.get(background_entity2);
+			MotionRef background_motion2 = motionRegistry.get(background_entity2);
 			background_motion2.velocity.x = -100;
 
 			playerMoving = true;
 		}
 		else if ((action == GLFW_PRESS || action == GLFW_REPEAT) && key == GLFW_KEY_RIGHT) {
-			Motion& protagonist_motion = motionRegistry.get(player_protagonist);
+			MotionRef protagonist_motion = motionRegistry.get(player_protagonist);
 			protagonist_motion.scale.x = abs(protagonist_motion.scale.x);
 			protagonist_motion.velocity.x = 200.0f; // temporary until we implement a bounding box for character movement
 			// deal with background (parallaxing)
-			Motion& background_motion = motionRegistry.get(background_entity);
+			MotionRef background_motion = motionRegistry.get(background_entity);
 			background_motion.velocity.x = 100;
-			Motion& background_motion2 = motionRegistry.get(background_entity2);
+			MotionRef background_motion2 = motionRegistry.get(background_entity2);
 			background_motion2.velocity.x = 100;
 
 			playerMoving = true;
 		}
 		else if (action == GLFW_RELEASE && key == GLFW_KEY_LEFT) {
-			Motion& protagonist_motion = motionRegistry.get(player_protagonist);
+			MotionRef protagonist_motion = motionRegistry.get(player_protagonist);
 			if (protagonist_motion.velocity.x < 0) {
 				protagonist_motion.velocity.x = 0.0f; // temporary until we implement a bounding box for character movement
 
-				Motion& background_motion = motionRegistry.get(background_entity);
+				MotionRef background_motion = motionRegistry.get(background_entity);
 				background_motion.velocity.x = 0;
-				Motion& background_motion2 = motionRegistry.get(background_entity2);
+				MotionRef background_motion2 = motionRegistry.get(background_entity2);
 				background_motion2.velocity.x = 0;
 
 				playerMoving = false;
 			}
 		}
 		else if (action == GLFW_RELEASE && key == GLFW_KEY_RIGHT) {
-			Motion& protagonist_motion = motionRegistry.get(player_protagonist);
+			MotionRef protagonist_motion = motionRegistry.get(player_protagonist);
 			if (protagonist_motion.velocity.x > 0) {
 				protagonist_motion.velocity.x = 0.0f; // temporary until we implement a bounding box for character movement
 
-				Motion& background_motion = motionRegistry.get(background_entity);
+				MotionRef background_motion = motionRegistry.get(background_entity);
 				background_motion.velocity.x = 0;
-				Motion& background_motion2 = motionRegistry.get(background_entity2);
+				MotionRef background_motion2 = motionRegistry.get(background_entity2);
 				background_motion2.velocity.x = 0;
 
 				playerMoving = false;
@@ -2019,6 +2071,12 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 		debugging.in_debug_mode = !debugging.in_debug_mode;
 	}
 
+	// Append the container stats of this frame to ecs_stats.csv, for sizing the capacity profiles and spotting growth
+	if (action == GLFW_RELEASE && key == GLFW_KEY_S) {
+		if (write_stats_csv(registry.stats(), registry.current_tick(), "ecs_stats.csv"))
+			printf("Wrote the ECS stats of tick %u to ecs_stats.csv\n", registry.current_tick());
+	}
+
 	if (key == GLFW_KEY_F && action == GLFW_PRESS) {
 		display_fps = !display_fps;
 	}
@@ -2036,13 +2094,13 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 		current_speed += 0.1f;
 	}
 	current_speed = fmax(0.f, current_speed);
-	for (auto& motion : registry.motions.components) {
+	for (MotionRef motion : registry.motions.components) {
 		//std::cout << "Motion velocity finish x: " << motion.velocity.x << std::endl;
 	}
 
 	if (action == GLFW_PRESS && key == GLFW_KEY_SPACE) {
 		if (timeSinceBulletSpawn <= 0) {
-			createBullet(renderer);
+			createBullet(registry, renderer);
 			timeSinceBulletSpawn = 500;
 		}
 	}
@@ -12,6 +12,7 @@
 #include <SDL_mixer.h>
 
 #include "render_system.hpp"
+#include "tiny_ecs_registry.hpp"
 
 enum class LevelType {
     FOREST_LEVEL,
@@ -82,7 +83,8 @@ public:
 	bool display_fps = true;
 	float fps;
 
-	WorldSystem();
+	// The world spawns and simulates its entities in 'registry', its parallel loops run on 'threads'
+	WorldSystem(ECSRegistry& registry, ThreadPool& threads);
 
 	// Creates a window
 	GLFWwindow* create_window();
@@ -117,10 +119,16 @@ private:
 
     // Update the inventory
     void updateInventory();
+    // The inventory textures of the last rebuild and the registry tick it happened at
+    std::vector<ImmediateTexture> inventory_textures;
+    uint32_t inventory_tick = 0;
 
 	// OpenGL window handle
 	GLFWwindow* window;
 
+	ECSRegistry& registry;
+	ThreadPool& threads;
+
 	// Number of bug eaten by the chicken, displayed in the window title
 	unsigned int points;
 
@@ -133,6 +141,51 @@ private:
     unsigned int desertBossesKilled;
 	unsigned int iceBossesKilled;
 
+	// Bosses of each type that are in the registry and not dying, counted by the listeners connected in WorldSystem()
+	int forestBossesAlive = 0;
+	int desertBossesAlive = 0;
+	int iceBossesAlive = 0;
+
+	// The listeners connected to the registry's containers, disconnected when the world goes since the registry may outlive it
+	std::vector<Connection> connections;
+	void listen(Signal& signal, std::function<void(Entity)> listener)
+	{
+		connections.emplace_back(signal, signal.connect(std::move(listener)));
+	}
+
+	// Enemies and rocks spawned in the current level
+	int currentForestBosses = 0;
+	int currentDesertBosses = 0;
+	int currentIceBosses = 0;
+	int scorpionsSpawned = 0;
+	int ice1Spawned = 0;
+	int ice2Spawned = 0;
+	int snakesSpawned = 0;
+	int forestEnemySpawned = 0;
+	int obstaclesSpawned = 0;
+	int numRocks = 0;
+	// The last boss spawned of each type, its projectiles start from it
+	Entity forestBoss;
+	Entity desertBoss;
+	Entity iceBoss;
+
+	// Milliseconds since the last projectile and animation frame, the bullet one counts down to the next shot
+	float timeSinceBulletSpawn = 0;
+	float timeSinceGrenadeSpawn = 0;
+	float timeSinceSnowballSpawn = 0;
+	float timeSinceTornadoSpawn = 0;
+	float timeSinceExplosionSwitch = 0;
+	float timeSinceDragonSwitch = 0;
+	float timeSincePlayerWalk = 500;
+	int currentPlayerSprite = 0;
+	int currentExplosionSprite = 0;
+	int currentDragonSprite = 0;
+	int prevDragonSprite = 1;
+	bool playerMoving = false;
+
+	// The velocity of the foreground in the current step, spawned enemies move along with it
+	vec2 foregroundVelocity = { 0.f, 0.f };
+
 	// Game state
 	RenderSystem* renderer;
 